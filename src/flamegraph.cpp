@@ -9,10 +9,12 @@
 
 #include <algorithm>
 #include <cmath>
+#include <memory>
 #include <utility>
 
 #include <QAction>
 #include <QApplication>
+#include <QBitArray>
 #include <QCheckBox>
 #include <QClipboard>
 #include <QComboBox>
@@ -21,12 +23,13 @@
 #include <QDoubleSpinBox>
 #include <QEvent>
 #include <QFontDatabase>
-#include <QGraphicsRectItem>
+#include <QGraphicsItem>
 #include <QGraphicsScene>
 #include <QGraphicsView>
 #include <QLabel>
 #include <QLineEdit>
 #include <QMenu>
+#include <QPromise>
 #include <QRandomGenerator>
 #include <QScrollBar>
 #include <QStyleOption>
@@ -81,234 +84,6 @@ private:
 };
 }
 
-class FrameGraphicsItem : public QGraphicsRectItem
-{
-public:
-    FrameGraphicsItem(qint64 cost, Data::Symbol symbol, FrameGraphicsItem* parent);
-
-    qint64 cost() const;
-    void setCost(qint64 cost);
-    Data::Symbol symbol() const;
-
-    void paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget = nullptr) override;
-
-    QString description() const;
-    void setSearchMatchType(SearchMatchType matchType);
-
-    bool isExternallyHovered() const;
-    void setIsExternallyHovered(bool isExternallyHovered);
-
-protected:
-    void hoverEnterEvent(QGraphicsSceneHoverEvent* event) override;
-    void hoverLeaveEvent(QGraphicsSceneHoverEvent* event) override;
-
-private:
-    qint64 m_cost;
-    Data::Symbol m_symbol;
-    bool m_isHovered = false;
-    bool m_isExternallyHovered = false;
-    SearchMatchType m_searchMatch = NoSearch;
-};
-Q_DECLARE_METATYPE(FrameGraphicsItem*)
-
-namespace {
-class FrameGraphicsRootItem : public FrameGraphicsItem
-{
-public:
-    FrameGraphicsRootItem(const qint64 totalCost, Data::Costs::Unit unit, QString costName, const QString& label)
-        : FrameGraphicsItem(totalCost, {label, {}}, nullptr)
-        , m_costName(std::move(costName))
-        , m_unit(unit)
-    {
-    }
-
-    Data::Costs::Unit unit() const
-    {
-        return m_unit;
-    }
-    QString costName() const
-    {
-        return m_costName;
-    }
-
-private:
-    QString m_costName;
-    Data::Costs::Unit m_unit;
-};
-}
-
-Q_DECLARE_METATYPE(FrameGraphicsRootItem*)
-
-FrameGraphicsItem::FrameGraphicsItem(const qint64 cost, Data::Symbol symbol, FrameGraphicsItem* parent)
-    : QGraphicsRectItem(parent)
-    , m_cost(cost)
-    , m_symbol(std::move(symbol))
-{
-    setFlag(QGraphicsItem::ItemIsSelectable);
-    setAcceptHoverEvents(true);
-}
-
-qint64 FrameGraphicsItem::cost() const
-{
-    return m_cost;
-}
-
-void FrameGraphicsItem::setCost(qint64 cost)
-{
-    m_cost = cost;
-}
-
-Data::Symbol FrameGraphicsItem::symbol() const
-{
-    return m_symbol;
-}
-
-void FrameGraphicsItem::paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* /*widget*/)
-{
-    if (isSelected() || m_isHovered || m_isExternallyHovered || m_searchMatch == DirectMatch) {
-        auto selectedColor = brush().color();
-        selectedColor.setAlpha(255);
-        painter->fillRect(rect(), selectedColor);
-    } else if (m_searchMatch == NoMatch) {
-        auto noMatchColor = brush().color();
-        noMatchColor.setAlpha(50);
-        painter->fillRect(rect(), noMatchColor);
-    } else {
-        // default, when no search is running, or a sub-item is matched
-        auto background = brush();
-
-        // give inline frames a slightly different background color
-        if (m_symbol.isInline) {
-            auto color = background.color();
-            if (qGray(pen().color().rgb()) < 128) {
-                color = color.lighter();
-            } else {
-                color = color.darker();
-            }
-            background.setColor(color);
-        }
-        painter->fillRect(rect(), background);
-
-        // give inline frames a border with the normal background color
-        if (m_symbol.isInline) {
-            const auto oldPen = painter->pen();
-            painter->setPen(QPen(brush().color(), 0.));
-            painter->drawRect(rect().adjusted(-1, -1, -1, -1));
-            painter->setPen(oldPen);
-        }
-    }
-
-    const QPen oldPen = painter->pen();
-    auto pen = oldPen;
-    if (m_searchMatch != NoMatch) {
-        pen.setColor(brush().color());
-        if (isSelected()) {
-            pen.setWidth(2);
-        }
-        painter->setPen(pen);
-        painter->drawRect(rect());
-        painter->setPen(oldPen);
-    }
-
-    const int margin = 4;
-    const int width = rect().width() - (2 * margin);
-    if (width < option->fontMetrics.averageCharWidth() * 6) {
-        // text is too wide for the current LOD, don't paint it
-        return;
-    }
-
-    if (m_searchMatch == NoMatch) {
-        auto color = oldPen.color();
-        color.setAlpha(125);
-        pen.setColor(color);
-        painter->setPen(pen);
-    }
-
-    const int height = rect().height();
-    const auto binary = Util::formatString(m_symbol.binary);
-    const auto symbol = Util::formatSymbol(m_symbol, false);
-    const auto symbolText = symbol.isEmpty() ? QObject::tr("?? [%1]").arg(binary) : symbol;
-    painter->drawText(margin + rect().x(), rect().y(), width, height,
-                      Qt::AlignVCenter | Qt::AlignLeft | Qt::TextSingleLine,
-                      Util::elideSymbol(symbolText, option->fontMetrics, width));
-
-    if (m_searchMatch == NoMatch) {
-        painter->setPen(oldPen);
-    }
-}
-
-void FrameGraphicsItem::hoverEnterEvent(QGraphicsSceneHoverEvent* event)
-{
-    QGraphicsRectItem::hoverEnterEvent(event);
-    m_isHovered = true;
-    update();
-}
-
-void FrameGraphicsItem::hoverLeaveEvent(QGraphicsSceneHoverEvent* event)
-{
-    QGraphicsRectItem::hoverLeaveEvent(event);
-    m_isHovered = false;
-    update();
-}
-
-QString FrameGraphicsItem::description() const
-{
-    // we build the tooltip text on demand, which is much faster than doing that for potentially thousands of items when
-    // we load the data
-    const FrameGraphicsRootItem* root = nullptr;
-    {
-        auto item = this;
-        while (item->parentItem()) {
-            item = static_cast<const FrameGraphicsItem*>(item->parentItem());
-        }
-        root = static_cast<const FrameGraphicsRootItem*>(item);
-    }
-
-    auto symbol = Util::formatSymbolExtended(m_symbol);
-    if (root == this) {
-        return symbol;
-    }
-
-    switch (root->unit()) {
-    case Data::Costs::Unit::Unknown:
-        return i18nc("%1: aggregated sample costs, %2: relative number, %3: function label, %4: binary, %5: cost name",
-                     "%1 (%2%) aggregated %5 costs in %3 (%4) and below.",
-                     Data::Costs::formatCost(root->unit(), m_cost), Util::formatCostRelative(m_cost, root->cost()),
-                     symbol, m_symbol.binary, root->costName());
-    case Data::Costs::Unit::Tracepoint:
-        return i18nc("%1: number of tracepoint events, %2: relative number, %3: function label, %4: binary",
-                     "%1 (%2%) aggregated %5 events in %3 (%4) and below.",
-                     Data::Costs::formatCost(root->unit(), m_cost), Util::formatCostRelative(m_cost, root->cost()),
-                     symbol, m_symbol.binary, root->costName());
-    case Data::Costs::Unit::Time:
-        return i18nc("%1: elapsed time, %2: relative number, %3: function label, %4: binary",
-                     "%1 (%2%) aggregated %5 in %3 (%4) and below.", Data::Costs::formatCost(root->unit(), m_cost),
-                     Util::formatCostRelative(m_cost, root->cost()), symbol, m_symbol.binary, root->costName());
-    }
-    Q_UNREACHABLE();
-}
-
-void FrameGraphicsItem::setSearchMatchType(SearchMatchType matchType)
-{
-    if (m_searchMatch != matchType) {
-        m_searchMatch = matchType;
-        update();
-    }
-}
-
-bool FrameGraphicsItem::isExternallyHovered() const
-{
-    return m_isExternallyHovered;
-}
-
-void FrameGraphicsItem::setIsExternallyHovered(bool externallyHovered)
-{
-    if (m_isExternallyHovered != externallyHovered) {
-        m_isExternallyHovered = externallyHovered;
-        update();
-    }
-}
-
 namespace {
 
 int randInt(int max)
@@ -454,143 +229,517 @@ QBrush brush(const Data::Symbol& entry, const BrushConfig& brushConfig, quint32
     return {};
 }
 
+struct SearchResults
+{
+    SearchMatchType matchType = NoMatch;
+    qint64 directCost = 0;
+};
+}
+
 /**
- * Layout the flame graph and hide tiny items.
+ * The frames of a flame graph, built once per result snapshot.
+ *
+ * The children of every frame are stored next to each other, sorted by their symbol, and all frames are ordered
+ * by their depth. The first frame is the root. The costs of all types are indexed by frame, which allows us to
+ * switch between cost types without rebuilding the frames.
  */
-void layoutItems(FrameGraphicsItem* parent)
-{
-    const auto& parentRect = parent->rect();
-    const auto pos = parentRect.topLeft();
-    const qreal maxWidth = parentRect.width();
-    const qreal h = parentRect.height();
-    const qreal y_margin = 2.;
-    const qreal y = pos.y() - h - y_margin;
-    qreal x = pos.x();
-
-    auto children = parent->childItems();
-    // sort to get reproducible graphs
-    std::sort(children.begin(), children.end(), [](const QGraphicsItem* lhs, const QGraphicsItem* rhs) {
-        return static_cast<const FrameGraphicsItem*>(lhs)->symbol()
-            < static_cast<const FrameGraphicsItem*>(rhs)->symbol();
-    });
+struct FlameGraphFrames
+{
+    struct Frame
+    {
+        qint32 symbolId = -1;
+        qint32 parent = -1;
+        qint32 firstChild = 0;
+        qint32 numChildren = 0;
+        qint32 depth = 0;
+    };
+
+    QVector<Frame> frames;
+    Data::SymbolTable symbolTable;
+    Data::Costs costs;
+};
+
+/**
+ * Renders the complete flame graph for one cost type from the frames.
+ *
+ * Only the frames that are wide enough get laid out, they are kept sorted by their position per depth which
+ * allows us to cull and hit-test them via binary searches. Runs of frames that are too small to be shown
+ * individually get merged into slivers.
+ */
+class FlameGraphItem : public QGraphicsItem
+{
+public:
+    FlameGraphItem(std::shared_ptr<const FlameGraphFrames> frames, QPen pen, QBrush rootBrush);
+
+    QRectF boundingRect() const override;
+    void paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget = nullptr) override;
+
+    // call layout afterwards, the children of frames with a cost below @p costThreshold percent will be hidden
+    void setCostType(int type, double costThreshold, const BrushConfig& brushConfig);
+
+    qint64 cost(int frame) const
+    {
+        return m_data->costs.cost(m_type, frame);
+    }
+
+    int parentFrame(int frame) const
+    {
+        return m_data->frames[frame].parent;
+    }
+
+    const Data::Symbol& symbol(int frame) const
+    {
+        return frame == 0 ? m_rootSymbol : m_data->symbolTable.symbols[m_data->frames[frame].symbolId];
+    }
+
+    const Data::SymbolTable& symbolTable() const
+    {
+        return m_data->symbolTable;
+    }
+
+    QPen pen() const
+    {
+        return m_pen;
+    }
+    void setPen(const QPen& pen);
+
+    QBrush rootBrush() const
+    {
+        return m_rootBrush;
+    }
+    void setRootBrush(const QBrush& brush);
+
+    QString description(int frame) const;
 
-    for (auto child : std::as_const(children)) {
-        auto frameChild = static_cast<FrameGraphicsItem*>(child);
-        const qreal w = maxWidth * static_cast<double>(frameChild->cost()) / parent->cost();
-        frameChild->setVisible(w > 1);
-        if (frameChild->isVisible()) {
-            frameChild->setRect(QRectF(x, y, w, h));
-            layoutItems(frameChild);
-            x += w;
+    // scale @p frame and its parents to @p width and layout everything below it
+    void layout(int frame, qreal width, qreal frameHeight);
+    QRectF frameRect(int frame) const;
+    // returns the visible frame at @p pos in item coordinates, or -1
+    int frameAt(QPointF pos) const;
+
+    void setSelectedFrame(int frame);
+    void setHoveredFrame(int frame);
+    // @p symbolMatches must be computed for the symbol table of this item
+    void setSearchMatches(Data::SymbolMatches symbolMatches);
+    SearchResults searchResults() const
+    {
+        return m_searchResults;
+    }
+    void hoverStacks(const QVector<QVector<Data::Symbol>>& stacks, bool skipFirstLevel);
+    void updateColorScheme(const BrushConfig& brushConfig);
+
+private:
+    struct Sliver
+    {
+        qreal x = 0;
+        qreal width = 0;
+        int frame = -1;
+    };
+
+    void layoutChildren(int parent);
+    void applySearch();
+    qreal depthToY(int depth) const;
+    bool hoverStack(int frame, const QVector<Data::Symbol>& stack, int depth);
+    void paintFrame(QPainter* painter, const QStyleOptionGraphicsItem* option, int frame) const;
+    QColor color(int frame) const;
+
+    std::shared_ptr<const FlameGraphFrames> m_data;
+    int m_type = 0;
+    qint64 m_costThreshold = 0;
+    Data::Symbol m_rootSymbol;
+    QPen m_pen;
+    QBrush m_rootBrush;
+    BrushConfig m_brushConfig;
+    // colors of the frames, computed when they get painted for the first time
+    mutable QVector<QRgb> m_colors;
+
+    // layout, x and width of every frame, zero width for invisible ones
+    QVector<qreal> m_x;
+    QVector<qreal> m_width;
+    QVector<QVector<qint32>> m_visibleFrames;
+    QVector<QVector<Sliver>> m_slivers;
+    qreal m_rootWidth = 0;
+    qreal m_frameHeight = 0;
+
+    Data::SymbolMatches m_symbolMatches;
+    QVector<SearchMatchType> m_searchMatch;
+    SearchResults m_searchResults = {NoSearch, 0};
+    QBitArray m_externallyHovered;
+    int m_selectedFrame = -1;
+    int m_hoveredFrame = -1;
+};
+
+namespace {
+const qreal Y_MARGIN = 2.;
+}
+
+FlameGraphItem::FlameGraphItem(std::shared_ptr<const FlameGraphFrames> frames, QPen pen, QBrush rootBrush)
+    : m_data(std::move(frames))
+    , m_pen(std::move(pen))
+    , m_rootBrush(std::move(rootBrush))
+    , m_colors(m_data->frames.size(), 0)
+    , m_x(m_data->frames.size(), 0)
+    , m_width(m_data->frames.size(), 0)
+    , m_searchMatch(m_data->frames.size(), NoSearch)
+    , m_externallyHovered(m_data->frames.size())
+{
+    // we need the exposed rect to only paint the visible frames
+    setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
+}
+
+void FlameGraphItem::setCostType(int type, double costThreshold, const BrushConfig& brushConfig)
+{
+    const auto& costs = m_data->costs;
+    const auto totalCost = costs.totalCost(type);
+    m_type = type;
+    m_costThreshold = static_cast<double>(totalCost) * costThreshold / 100.;
+    m_rootSymbol = {i18n("%1 aggregated %2 cost in total", costs.formatCost(type, totalCost), costs.typeName(type)),
+                    {}};
+    updateColorScheme(brushConfig);
+    if (m_symbolMatches.isActive()) {
+        applySearch();
+    }
+}
+
+QRectF FlameGraphItem::boundingRect() const
+{
+    const auto maxDepth = std::max<int>(0, m_visibleFrames.size() - 1);
+    return QRectF(0, depthToY(maxDepth), m_rootWidth, m_frameHeight - depthToY(maxDepth));
+}
+
+qreal FlameGraphItem::depthToY(int depth) const
+{
+    return -depth * (m_frameHeight + Y_MARGIN);
+}
+
+QRectF FlameGraphItem::frameRect(int frame) const
+{
+    return QRectF(m_x[frame], depthToY(m_data->frames[frame].depth), m_width[frame], m_frameHeight);
+}
+
+void FlameGraphItem::setPen(const QPen& pen)
+{
+    m_pen = pen;
+    update();
+}
+
+void FlameGraphItem::setRootBrush(const QBrush& brush)
+{
+    m_rootBrush = brush;
+    update();
+}
+
+void FlameGraphItem::layout(int frame, qreal width, qreal frameHeight)
+{
+    prepareGeometryChange();
+
+    m_rootWidth = width;
+    m_frameHeight = frameHeight;
+    std::fill(m_width.begin(), m_width.end(), 0);
+    m_visibleFrames.clear();
+    m_slivers.clear();
+
+    // the frame and its parents span the complete width, all of their siblings are hidden
+    const auto& frames = m_data->frames;
+    const auto depth = frames[frame].depth;
+    m_visibleFrames.resize(depth + 1);
+    m_slivers.resize(depth + 1);
+    for (auto parent = frame; parent != -1; parent = frames[parent].parent) {
+        m_x[parent] = 0;
+        m_width[parent] = width;
+        m_visibleFrames[frames[parent].depth].append(parent);
+    }
+
+    layoutChildren(frame);
+}
+
+void FlameGraphItem::layoutChildren(int parent)
+{
+    const auto& parentFrame = m_data->frames[parent];
+    const auto parentCost = cost(parent);
+    if (!parentFrame.numChildren || parentCost <= m_costThreshold) {
+        return;
+    }
+
+    const auto depth = parentFrame.depth + 1;
+    if (m_visibleFrames.size() <= depth) {
+        m_visibleFrames.resize(depth + 1);
+        m_slivers.resize(depth + 1);
+    }
+
+    const qreal maxWidth = m_width[parent];
+    qreal x = m_x[parent];
+    Sliver sliver;
+    auto flushSliver = [&]() {
+        if (sliver.width >= 1) {
+            m_slivers[depth].append(sliver);
         }
+        sliver = {};
+    };
+
+    for (int child = parentFrame.firstChild, end = child + parentFrame.numChildren; child < end; ++child) {
+        const qreal w = maxWidth * static_cast<double>(cost(child)) / parentCost;
+        if (w > 1) {
+            flushSliver();
+            m_x[child] = x;
+            m_width[child] = w;
+            m_visibleFrames[depth].append(child);
+            layoutChildren(child);
+        } else {
+            // frames that are too small to be shown get merged with their small neighbors
+            if (sliver.frame == -1) {
+                sliver.x = x;
+                sliver.frame = child;
+            }
+            sliver.width += w;
+        }
+        x += w;
+    }
+    flushSliver();
+}
+
+int FlameGraphItem::frameAt(QPointF pos) const
+{
+    if (m_frameHeight <= 0) {
+        return -1;
+    }
+
+    const auto depth = static_cast<int>(std::ceil(-pos.y() / (m_frameHeight + Y_MARGIN)));
+    if (depth < 0 || depth >= m_visibleFrames.size() || pos.y() < depthToY(depth)
+        || pos.y() > depthToY(depth) + m_frameHeight) {
+        return -1;
+    }
+
+    const auto& frames = m_visibleFrames[depth];
+    auto it = std::upper_bound(frames.cbegin(), frames.cend(), pos.x(),
+                               [this](qreal x, qint32 frame) { return x < m_x[frame]; });
+    if (it == frames.cbegin()) {
+        return -1;
     }
+    --it;
+    return pos.x() <= m_x[*it] + m_width[*it] ? *it : -1;
 }
 
-FrameGraphicsItem* findItemBySymbol(const QList<QGraphicsItem*>& items, const Data::Symbol& symbol)
+void FlameGraphItem::paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* /*widget*/)
 {
-    for (auto item_ : items) {
-        auto item = static_cast<FrameGraphicsItem*>(item_);
-        if (item->symbol() == symbol) {
-            return item;
+    const auto exposed = option->exposedRect;
+    const auto rowHeight = m_frameHeight + Y_MARGIN;
+    const auto minDepth = std::max(0, static_cast<int>(std::ceil(-exposed.bottom() / rowHeight)));
+    const auto maxDepth = std::min(static_cast<int>(m_visibleFrames.size()) - 1,
+                                   static_cast<int>(std::floor((m_frameHeight - exposed.top()) / rowHeight)));
+
+    for (int depth = minDepth; depth <= maxDepth; ++depth) {
+        const auto y = depthToY(depth);
+
+        const auto& slivers = m_slivers[depth];
+        auto sliver =
+            std::lower_bound(slivers.cbegin(), slivers.cend(), exposed.left(),
+                             [](const Sliver& candidate, qreal x) { return candidate.x + candidate.width < x; });
+        for (; sliver != slivers.cend() && sliver->x <= exposed.right(); ++sliver) {
+            const auto frame = sliver->frame;
+            auto color = this->color(frame);
+            if (m_searchMatch[frame] == NoMatch) {
+                color.setAlpha(50);
+            }
+            painter->fillRect(QRectF(sliver->x, y, sliver->width, m_frameHeight), color);
+        }
+
+        const auto& frames = m_visibleFrames[depth];
+        auto it = std::lower_bound(frames.cbegin(), frames.cend(), exposed.left(),
+                                   [this](qint32 frame, qreal x) { return m_x[frame] + m_width[frame] < x; });
+        for (; it != frames.cend() && m_x[*it] <= exposed.right(); ++it) {
+            paintFrame(painter, option, *it);
         }
     }
-    return nullptr;
 }
 
-/**
- * Convert the top-down graph into a tree of FrameGraphicsItem.
- */
-template<typename Tree>
-void toGraphicsItems(const Data::Costs& costs, int type, const QVector<Tree>& data, FrameGraphicsItem* parent,
-                     const double costThreshold, const BrushConfig& brushConfig, bool collapseRecursion)
+void FlameGraphItem::paintFrame(QPainter* painter, const QStyleOptionGraphicsItem* option, int frame) const
 {
-    for (const auto& row : data) {
-        if (collapseRecursion && !row.symbol.symbol.isEmpty() && row.symbol == parent->symbol()) {
-            if (costs.cost(type, row.id) > costThreshold) {
-                toGraphicsItems(costs, type, row.children, parent, costThreshold, brushConfig, collapseRecursion);
+    const auto rect = frameRect(frame);
+    const auto& symbol = this->symbol(frame);
+    const auto searchMatch = m_searchMatch[frame];
+    const auto brush = frame == 0 ? m_rootBrush : QBrush(color(frame));
+    const bool isSelected = frame == m_selectedFrame;
+
+    if (isSelected || frame == m_hoveredFrame || m_externallyHovered.testBit(frame) || searchMatch == DirectMatch) {
+        auto selectedColor = brush.color();
+        selectedColor.setAlpha(255);
+        painter->fillRect(rect, selectedColor);
+    } else if (searchMatch == NoMatch) {
+        auto noMatchColor = brush.color();
+        noMatchColor.setAlpha(50);
+        painter->fillRect(rect, noMatchColor);
+    } else {
+        // default, when no search is running, or a sub-item is matched
+        auto background = brush;
+
+        // give inline frames a slightly different background color
+        if (symbol.isInline) {
+            auto color = background.color();
+            if (qGray(m_pen.color().rgb()) < 128) {
+                color = color.lighter();
+            } else {
+                color = color.darker();
             }
-            continue;
+            background.setColor(color);
         }
-        auto item = findItemBySymbol(parent->childItems(), row.symbol);
-        if (!item) {
-            item = new FrameGraphicsItem(costs.cost(type, row.id), row.symbol, parent);
-            item->setPen(parent->pen());
-            item->setBrush(brush(row.symbol, brushConfig, item->cost(), costs.totalCost(type)));
-        } else {
-            item->setCost(item->cost() + costs.cost(type, row.id));
+        painter->fillRect(rect, background);
+
+        // give inline frames a border with the normal background color
+        if (symbol.isInline) {
+            const auto oldPen = painter->pen();
+            painter->setPen(QPen(brush.color(), 0.));
+            painter->drawRect(rect.adjusted(-1, -1, -1, -1));
+            painter->setPen(oldPen);
         }
-        if (item->cost() > costThreshold) {
-            toGraphicsItems(costs, type, row.children, item, costThreshold, brushConfig, collapseRecursion);
+    }
+
+    const QPen oldPen = painter->pen();
+    auto pen = oldPen;
+    if (searchMatch != NoMatch) {
+        pen.setColor(brush.color());
+        if (isSelected) {
+            pen.setWidth(2);
         }
+        painter->setPen(pen);
+        painter->drawRect(rect);
+        painter->setPen(oldPen);
+    }
+
+    const int margin = 4;
+    const int width = rect.width() - (2 * margin);
+    if (width < option->fontMetrics.averageCharWidth() * 6) {
+        // text is too wide for the current LOD, don't paint it
+        return;
+    }
+
+    if (searchMatch == NoMatch) {
+        auto color = oldPen.color();
+        color.setAlpha(125);
+        pen.setColor(color);
+        painter->setPen(pen);
+    }
+
+    const int height = rect.height();
+    const auto binary = Util::formatString(symbol.binary);
+    const auto formattedSymbol = Util::formatSymbol(symbol, false);
+    const auto symbolText = formattedSymbol.isEmpty() ? QObject::tr("?? [%1]").arg(binary) : formattedSymbol;
+    painter->drawText(margin + rect.x(), rect.y(), width, height, Qt::AlignVCenter | Qt::AlignLeft | Qt::TextSingleLine,
+                      Util::elideSymbol(symbolText, option->fontMetrics, width));
+
+    if (searchMatch == NoMatch) {
+        painter->setPen(oldPen);
     }
 }
 
-template<typename Tree>
-FrameGraphicsItem* parseData(const Data::Costs& costs, int type, const QVector<Tree>& topDownData, double costThreshold,
-                             const BrushConfig& brushConfig, bool collapseRecursion)
+QString FlameGraphItem::description(int frame) const
 {
-    const auto totalCost = costs.totalCost(type);
+    // we build the tooltip text on demand, which is much faster than doing that for potentially thousands of items when
+    // we load the data
+    const auto& symbol = this->symbol(frame);
+    auto formattedSymbol = Util::formatSymbolExtended(symbol);
+    if (frame == 0) {
+        return formattedSymbol;
+    }
 
-    const auto scheme = KColorScheme(QPalette::Active);
-    const auto pen = QPen(scheme.foreground().color());
+    const auto cost = this->cost(frame);
+    const auto totalCost = this->cost(0);
+    const auto unit = m_data->costs.unit(m_type);
+    const auto costName = m_data->costs.typeName(m_type);
+    switch (unit) {
+    case Data::Costs::Unit::Unknown:
+        return i18nc("%1: aggregated sample costs, %2: relative number, %3: function label, %4: binary, %5: cost name",
+                     "%1 (%2%) aggregated %5 costs in %3 (%4) and below.", Data::Costs::formatCost(unit, cost),
+                     Util::formatCostRelative(cost, totalCost), formattedSymbol, symbol.binary, costName);
+    case Data::Costs::Unit::Tracepoint:
+        return i18nc("%1: number of tracepoint events, %2: relative number, %3: function label, %4: binary",
+                     "%1 (%2%) aggregated %5 events in %3 (%4) and below.", Data::Costs::formatCost(unit, cost),
+                     Util::formatCostRelative(cost, totalCost), formattedSymbol, symbol.binary, costName);
+    case Data::Costs::Unit::Time:
+        return i18nc("%1: elapsed time, %2: relative number, %3: function label, %4: binary",
+                     "%1 (%2%) aggregated %5 in %3 (%4) and below.", Data::Costs::formatCost(unit, cost),
+                     Util::formatCostRelative(cost, totalCost), formattedSymbol, symbol.binary, costName);
+    }
+    Q_UNREACHABLE();
+}
 
-    const auto label = i18n("%1 aggregated %2 cost in total", costs.formatCost(type, totalCost), costs.typeName(type));
-    auto rootItem = new FrameGraphicsRootItem(totalCost, costs.unit(type), costs.typeName(type), label);
-    rootItem->setBrush(scheme.background());
-    rootItem->setPen(pen);
-    toGraphicsItems(costs, type, topDownData, rootItem, static_cast<double>(totalCost) * costThreshold / 100.,
-                    brushConfig, collapseRecursion);
-    return rootItem;
+void FlameGraphItem::setSelectedFrame(int frame)
+{
+    m_selectedFrame = frame;
+    update();
 }
 
-struct SearchResults
+void FlameGraphItem::setHoveredFrame(int frame)
 {
-    SearchMatchType matchType = NoMatch;
-    qint64 directCost = 0;
-};
+    if (m_hoveredFrame != frame) {
+        m_hoveredFrame = frame;
+        update();
+    }
+}
 
-SearchResults applySearch(FrameGraphicsItem* item, const QRegularExpression& expression)
+void FlameGraphItem::setSearchMatches(Data::SymbolMatches symbolMatches)
 {
-    SearchResults result;
-    if (expression.pattern().isEmpty()) {
-        result.matchType = NoSearch;
-    } else if (expression.match(item->symbol().symbol).hasMatch() || expression.match(item->symbol().binary).hasMatch()
-               || (expression.pattern() == QLatin1String("\\?\\?") && item->symbol().symbol.isEmpty())) {
-        result.directCost += item->cost();
-        result.matchType = DirectMatch;
+    m_symbolMatches = std::move(symbolMatches);
+    applySearch();
+}
+
+void FlameGraphItem::applySearch()
+{
+    if (!m_symbolMatches.isActive()) {
+        std::fill(m_searchMatch.begin(), m_searchMatch.end(), NoSearch);
+        m_searchResults = {NoSearch, 0};
+        update();
+        return;
     }
 
-    // recurse into the child items, we always need to update all items
-    const auto children = item->childItems();
-    for (auto* child : children) {
-        auto* childFrame = static_cast<FrameGraphicsItem*>(child);
-        auto childMatch = applySearch(childFrame, expression);
-        if (result.matchType != DirectMatch
-            && (childMatch.matchType == DirectMatch || childMatch.matchType == ChildMatch)) {
-            result.matchType = ChildMatch;
-            result.directCost += childMatch.directCost;
+    const auto& frames = m_data->frames;
+    QVector<qint64> directCosts(frames.size(), 0);
+    QVector<qint64> childCosts(frames.size(), 0);
+    QBitArray childMatches(frames.size());
+
+    // children always come after their parents, so walk backwards to handle them first
+    for (int frame = frames.size() - 1; frame >= 0; --frame) {
+        // the root symbol depends on the cost type and isn't part of the symbol table
+        const bool isMatch =
+            frame == 0 ? m_symbolMatches.matches(m_rootSymbol) : m_symbolMatches.matches(frames[frame].symbolId);
+        auto& matchType = m_searchMatch[frame];
+        if (isMatch) {
+            matchType = DirectMatch;
+            directCosts[frame] = cost(frame);
+        } else if (childMatches.testBit(frame)) {
+            matchType = ChildMatch;
+            directCosts[frame] = childCosts[frame];
+        } else {
+            matchType = NoMatch;
+        }
+
+        const auto parent = frames[frame].parent;
+        if (parent != -1 && matchType != NoMatch) {
+            childMatches.setBit(parent);
+            childCosts[parent] += directCosts[frame];
         }
     }
 
-    item->setSearchMatchType(result.matchType);
-    return result;
+    m_searchResults = {m_searchMatch[0], directCosts[0]};
+    update();
 }
 
 // only apply positive matching, resetting is handled globally once before
 // this way we can correctly match multiple stacks
-bool hoverStack(FrameGraphicsItem* item, const QVector<Data::Symbol>& stack, int depth)
+bool FlameGraphItem::hoverStack(int frame, const QVector<Data::Symbol>& stack, int depth)
 {
-    if ((stack.size() - 1) == depth && item->symbol() == stack.constFirst()) {
-        item->setIsExternallyHovered(true);
+    const auto& symbol = this->symbol(frame);
+    if ((stack.size() - 1) == depth && symbol == stack.constFirst()) {
+        m_externallyHovered.setBit(frame);
         return true;
-    } else if (stack.size() <= depth || item->symbol() != stack[stack.size() - 1 - depth]) {
+    } else if (stack.size() <= depth || symbol != stack[stack.size() - 1 - depth]) {
         return false;
     }
 
-    const auto children = item->childItems();
-    for (auto* child : children) {
-        if (hoverStack(static_cast<FrameGraphicsItem*>(child), stack, depth + 1)) {
-            item->setIsExternallyHovered(true);
+    const auto& parent = m_data->frames[frame];
+    for (int child = parent.firstChild, end = child + parent.numChildren; child < end; ++child) {
+        if (hoverStack(child, stack, depth + 1)) {
+            m_externallyHovered.setBit(frame);
             return true;
         }
     }
@@ -598,56 +747,172 @@ bool hoverStack(FrameGraphicsItem* item, const QVector<Data::Symbol>& stack, int
     return false;
 }
 
-void resetIsExternallyHovered(FrameGraphicsItem* item)
+void FlameGraphItem::hoverStacks(const QVector<QVector<Data::Symbol>>& stacks, bool skipFirstLevel)
 {
-    if (!item->isExternallyHovered()) {
-        // when nothing is hovered we don't need to recurse
-        return;
-    }
-    item->setIsExternallyHovered(false);
-    const auto children = item->childItems();
-    for (auto* child : children) {
-        resetIsExternallyHovered(static_cast<FrameGraphicsItem*>(child));
-    }
-}
+    // reset everything first
+    m_externallyHovered.fill(false);
 
-void hoverStacks(FrameGraphicsItem* rootItem, const QVector<QVector<Data::Symbol>>& stacks)
-{
-    auto matchStacks = [&stacks](QGraphicsItem* item) {
-        return std::any_of(stacks.begin(), stacks.end(), [item](const auto& stack) {
-            return hoverStack(static_cast<FrameGraphicsItem*>(item), stack, 0);
-        });
+    // then match all stacks
+    auto matchStacks = [this, &stacks](int frame) {
+        return std::any_of(stacks.begin(), stacks.end(),
+                           [this, frame](const auto& stack) { return hoverStack(frame, stack, 0); });
     };
 
-    const auto children = rootItem->childItems();
-    const auto costAggregation = Settings::instance()->costAggregation();
-    const auto skipFirstLevel = costAggregation != Settings::CostAggregation::BySymbol;
-    for (auto* child : children) {
-        // reset everything first
-        resetIsExternallyHovered(static_cast<FrameGraphicsItem*>(child));
-
-        // then match all stacks
+    const auto& frames = m_data->frames;
+    const auto& root = frames[0];
+    for (int child = root.firstChild, end = child + root.numChildren; child < end; ++child) {
         if (skipFirstLevel) {
-            // skip first level
-            const auto grandChildren = child->childItems();
+            const auto& frame = frames[child];
             bool anyMatched = false;
-            for (auto* grandChild : grandChildren) {
+            for (int grandChild = frame.firstChild, end = grandChild + frame.numChildren; grandChild < end;
+                 ++grandChild) {
                 anyMatched |= matchStacks(grandChild);
             }
-            static_cast<FrameGraphicsItem*>(child)->setIsExternallyHovered(anyMatched);
+            m_externallyHovered.setBit(child, anyMatched);
         } else {
             matchStacks(child);
         }
     }
+
+    update();
 }
 
-void updateFlameGraphColorScheme(FrameGraphicsItem* item, const BrushConfig& brushConfig, quint32 totalCost)
+void FlameGraphItem::updateColorScheme(const BrushConfig& brushConfig)
 {
-    item->setBrush(brush(item->symbol(), brushConfig, item->cost(), totalCost));
-    const auto children = item->childItems();
-    for (const auto& child : children) {
-        updateFlameGraphColorScheme(static_cast<FrameGraphicsItem*>(child), brushConfig, totalCost);
+    m_brushConfig = brushConfig;
+    std::fill(m_colors.begin(), m_colors.end(), 0);
+    update();
+}
+
+QColor FlameGraphItem::color(int frame) const
+{
+    // all brushes are semi-transparent, so zero is never a valid color
+    auto& color = m_colors[frame];
+    if (!color) {
+        color = brush(symbol(frame), m_brushConfig, cost(frame), cost(0)).color().rgba();
     }
+    return QColor::fromRgba(color);
+}
+
+namespace {
+using FlameGraphPromise = QPromise<std::shared_ptr<const FlameGraphFrames>>;
+
+class FlameGraphBuilder
+{
+public:
+    FlameGraphBuilder(const Data::Costs& costs, bool collapseRecursion, const FlameGraphPromise& promise)
+        : m_costs(costs)
+        , m_collapseRecursion(collapseRecursion)
+        , m_promise(promise)
+    {
+        m_nodeCosts.initializeCostsFrom(m_costs);
+    }
+
+    template<typename Tree>
+    std::shared_ptr<const FlameGraphFrames> build(const QVector<Tree>& topDownData)
+    {
+        // the root symbol depends on the cost type, see FlameGraphItem::setCostType
+        Node root;
+        root.id = m_numNodes++;
+        addChildren(topDownData, &root);
+        if (m_promise.isCanceled()) {
+            return {};
+        }
+        return flatten(root);
+    }
+
+private:
+    struct Node
+    {
+        quint32 id = 0;
+        qint32 symbolId = -1;
+        QVector<Node> children;
+    };
+
+    /**
+     * Convert the top-down graph into a tree of frames, merging frames of the same symbol.
+     */
+    template<typename Tree>
+    void addChildren(const QVector<Tree>& data, Node* parent)
+    {
+        for (const auto& row : data) {
+            if (m_promise.isCanceled()) {
+                return;
+            }
+            const auto id = m_symbolTable.insert(row.symbol);
+            if (m_collapseRecursion && !row.symbol.symbol.isEmpty() && id == parent->symbolId) {
+                addChildren(row.children, parent);
+                continue;
+            }
+            auto it = std::find_if(parent->children.begin(), parent->children.end(),
+                                   [id](const Node& node) { return node.symbolId == id; });
+            if (it == parent->children.end()) {
+                parent->children.append(Node{m_numNodes++, id, {}});
+                it = std::prev(parent->children.end());
+            }
+            m_nodeCosts.add(it->id, m_costs, row.id);
+            addChildren(row.children, &(*it));
+        }
+    }
+
+    std::shared_ptr<const FlameGraphFrames> flatten(const Node& root)
+    {
+        auto ret = std::make_shared<FlameGraphFrames>();
+        auto& frames = ret->frames;
+        auto& costs = ret->costs;
+        costs.initializeCostsFrom(m_costs);
+        for (int type = 0, c = m_costs.numTypes(); type < c; ++type) {
+            costs.add(type, 0, m_costs.totalCost(type));
+        }
+
+        frames.reserve(m_numNodes);
+        frames.append(FlameGraphFrames::Frame{root.symbolId, -1, 0, 0, 0});
+        QVector<const Node*> nodes;
+        nodes.reserve(m_numNodes);
+        nodes.append(&root);
+
+        // breadth first, to store the children of every frame next to each other
+        QVector<const Node*> children;
+        for (int i = 0; i < nodes.size(); ++i) {
+            children.clear();
+            for (const auto& child : nodes[i]->children) {
+                children.append(&child);
+            }
+            // sort to get reproducible graphs
+            std::sort(children.begin(), children.end(), [this](const Node* lhs, const Node* rhs) {
+                return m_symbolTable.symbols[lhs->symbolId] < m_symbolTable.symbols[rhs->symbolId];
+            });
+
+            frames[i].firstChild = frames.size();
+            frames[i].numChildren = children.size();
+            const auto depth = frames[i].depth + 1;
+            for (const auto* child : std::as_const(children)) {
+                costs.add(static_cast<quint32>(frames.size()), m_nodeCosts, child->id);
+                frames.append(FlameGraphFrames::Frame{child->symbolId, i, 0, 0, depth});
+                nodes.append(child);
+            }
+        }
+
+        // makes typing a search fast, even for huge flame graphs
+        m_symbolTable.buildIndex();
+        ret->symbolTable = std::move(m_symbolTable);
+        return ret;
+    }
+
+    const Data::Costs& m_costs;
+    const bool m_collapseRecursion;
+    const FlameGraphPromise& m_promise;
+    // costs of all types, indexed by node id
+    Data::Costs m_nodeCosts;
+    quint32 m_numNodes = 0;
+    Data::SymbolTable m_symbolTable;
+};
+
+template<typename Tree>
+std::shared_ptr<const FlameGraphFrames> buildFrames(const Data::Costs& costs, const QVector<Tree>& topDownData,
+                                                    bool collapseRecursion, const FlameGraphPromise& promise)
+{
+    return FlameGraphBuilder(costs, collapseRecursion, promise).build(topDownData);
 }
 }
 
@@ -660,7 +925,6 @@ FlameGraph::FlameGraph(QWidget* parent, Qt::WindowFlags flags)
     , m_searchResultsLabel(new QLabel(this))
 {
     m_displayLabel->setTextElideMode(Qt::ElideRight);
-    qRegisterMetaType<FrameGraphicsItem*>();
 
     m_costSource->setToolTip(i18n("Select the data source that should be visualized in the flame graph."));
 
@@ -731,7 +995,7 @@ FlameGraph::FlameGraph(QWidget* parent, Qt::WindowFlags flags)
 
             connect(costThreshold, qOverload<double>(&QDoubleSpinBox::valueChanged), this, [this](double threshold) {
                 m_costThreshold = threshold;
-                showData();
+                updateCostType();
             });
             layout->addWidget(costThreshold);
         },
@@ -778,13 +1042,8 @@ FlameGraph::FlameGraph(QWidget* parent, Qt::WindowFlags flags)
             auto setColorScheme = [this](Settings::ColorScheme scheme) {
                 Settings::instance()->setColorScheme(scheme);
 
-                if (m_rootItem) {
-                    const auto children = m_rootItem->childItems();
-                    // don't recolor the root item
-                    for (const auto& child : children) {
-                        updateFlameGraphColorScheme(static_cast<FrameGraphicsItem*>(child), brushConfig(scheme),
-                                                    m_rootItem->cost());
-                    }
+                if (m_item) {
+                    m_item->updateColorScheme(brushConfig(scheme));
                 }
             };
 
@@ -896,11 +1155,18 @@ void FlameGraph::setHoveredStacks(const QVector<QVector<Data::Symbol>>& hoveredS
         }
     }
 
-    if (m_rootItem) {
-        hoverStacks(m_rootItem, m_hoveredStacks);
+    if (m_item) {
+        hoverStacks();
     }
 }
 
+void FlameGraph::hoverStacks()
+{
+    const auto costAggregation = Settings::instance()->costAggregation();
+    const auto skipFirstLevel = costAggregation != Settings::CostAggregation::BySymbol;
+    m_item->hoverStacks(m_hoveredStacks, skipFirstLevel);
+}
+
 void FlameGraph::setFilterStack(FilterAndZoomStack* filterStack)
 {
     m_filterStack = filterStack;
@@ -913,14 +1179,14 @@ bool FlameGraph::eventFilter(QObject* object, QEvent* event)
     if (event->type() == QEvent::MouseButtonRelease) {
         auto* mouseEvent = static_cast<QMouseEvent*>(event);
         if (mouseEvent->button() == Qt::LeftButton) {
-            auto item = static_cast<FrameGraphicsItem*>(m_view->itemAt(mouseEvent->pos()));
-            if (item && item != m_selectionHistory.at(m_selectedItem)) {
-                selectItem(item);
+            const auto frame = frameAt(mouseEvent->pos());
+            if (frame != -1 && frame != m_selectionHistory.at(m_selectedItem)) {
+                selectFrame(frame);
                 if (m_selectedItem != m_selectionHistory.size() - 1) {
                     m_selectionHistory.remove(m_selectedItem + 1, m_selectionHistory.size() - m_selectedItem - 1);
                 }
                 m_selectedItem = m_selectionHistory.size();
-                m_selectionHistory.push_back(item);
+                m_selectionHistory.push_back(frame);
                 updateNavigationActions();
             }
         } else if (mouseEvent->button() == Qt::BackButton) {
@@ -930,43 +1196,51 @@ bool FlameGraph::eventFilter(QObject* object, QEvent* event)
         }
     } else if (event->type() == QEvent::MouseMove) {
         auto* mouseEvent = static_cast<QMouseEvent*>(event);
-        auto item = static_cast<FrameGraphicsItem*>(m_view->itemAt(mouseEvent->pos()));
-        setTooltipItem(item);
+        const auto frame = frameAt(mouseEvent->pos());
+        if (m_item) {
+            m_item->setHoveredFrame(frame);
+        }
+        setTooltipFrame(frame);
     } else if (event->type() == QEvent::Leave) {
-        setTooltipItem(nullptr);
+        if (m_item) {
+            m_item->setHoveredFrame(-1);
+        }
+        setTooltipFrame(-1);
     } else if (event->type() == QEvent::Resize || event->type() == QEvent::Show) {
-        if (!m_rootItem) {
+        if (!m_item) {
             if (!m_buildingScene) {
                 showData();
             }
         } else {
-            selectItem(m_selectionHistory.at(m_selectedItem));
+            selectFrame(m_selectionHistory.at(m_selectedItem));
         }
         updateTooltip();
     } else if (event->type() == QEvent::ContextMenu) {
         auto* contextEvent = static_cast<QContextMenuEvent*>(event);
-        auto item = static_cast<FrameGraphicsItem*>(m_view->itemAt(m_view->mapFromGlobal(contextEvent->globalPos())));
+        const auto frame = frameAt(m_view->mapFromGlobal(contextEvent->globalPos()));
 
         QMenu contextMenu;
-        if (item) {
+        Data::Symbol symbol;
+        if (frame != -1) {
+            symbol = m_item->symbol(frame);
             auto* viewCallerCallee = contextMenu.addAction(tr("View Caller/Callee"));
             connect(viewCallerCallee, &QAction::triggered, this,
-                    [this, item]() { emit jumpToCallerCallee(item->symbol()); });
+                    [this, symbol]() { emit jumpToCallerCallee(symbol); });
             auto* openEditorAction = contextMenu.addAction(tr("Open in Editor"));
-            connect(openEditorAction, &QAction::triggered, this, [this, item]() { emit openEditor(item->symbol()); });
-            openEditorAction->setEnabled(item->symbol().isValid());
+            connect(openEditorAction, &QAction::triggered, this, [this, symbol]() { emit openEditor(symbol); });
+            openEditorAction->setEnabled(symbol.isValid());
             contextMenu.addSeparator();
             auto* viewDisassembly = contextMenu.addAction(tr("Disassembly"));
-            connect(viewDisassembly, &QAction::triggered, this,
-                    [this, item]() { emit jumpToDisassembly(item->symbol()); });
-            viewDisassembly->setEnabled(item->symbol().canDisassemble());
+            connect(viewDisassembly, &QAction::triggered, this, [this, symbol]() { emit jumpToDisassembly(symbol); });
+            viewDisassembly->setEnabled(symbol.canDisassemble());
 
             auto* copy = contextMenu.addAction(QIcon::fromTheme(QStringLiteral("edit-copy")), tr("Copy"));
-            connect(copy, &QAction::triggered, this, [item]() { qApp->clipboard()->setText(item->description()); });
+            const auto description = m_item->description(frame);
+            connect(copy, &QAction::triggered, this, [description]() { qApp->clipboard()->setText(description); });
 
             contextMenu.addSeparator();
         }
-        ResultsUtil::addFilterActions(&contextMenu, item ? item->symbol() : Data::Symbol(), m_filterStack);
+        ResultsUtil::addFilterActions(&contextMenu, symbol, m_filterStack);
         contextMenu.addSeparator();
         contextMenu.addActions(actions());
 
@@ -1002,7 +1276,7 @@ void FlameGraph::setBottomUpData(const Data::BottomUpResults& bottomUpData)
     disconnect(m_costSource, nullptr, this, nullptr);
     ResultsUtil::fillEventSourceComboBox(m_costSource, bottomUpData.costs,
                                          tr("Show a flame graph over the aggregated %1 sample costs."));
-    connect(m_costSource, &QComboBox::currentIndexChanged, this, &FlameGraph::showData);
+    connect(m_costSource, &QComboBox::currentIndexChanged, this, &FlameGraph::updateCostType);
 
     rebuild();
 }
@@ -1012,6 +1286,7 @@ void FlameGraph::rebuild()
     if (isVisible()) {
         showData();
     } else {
+        cancelBuild();
         setData(nullptr);
     }
 }
@@ -1023,7 +1298,7 @@ void FlameGraph::clear()
 
 QImage FlameGraph::toImage() const
 {
-    if (!m_rootItem)
+    if (!m_item)
         return {};
 
     const auto sceneRect = m_scene->sceneRect();
@@ -1035,7 +1310,7 @@ QImage FlameGraph::toImage() const
 
 void FlameGraph::saveSvg(const QString& fileName) const
 {
-    if (!m_rootItem)
+    if (!m_item)
         return;
 
     const auto sceneRect = m_scene->sceneRect();
@@ -1053,16 +1328,16 @@ void FlameGraph::saveSvg(const QString& fileName) const
                                  .arg(costType, QString::number(m_costThreshold), m_displayLabel->text())
                                  .toHtmlEscaped());
 
-    const auto oldPen = m_rootItem->pen();
-    const auto oldBrush = m_rootItem->brush();
-    m_rootItem->setPen(QPen(Qt::black));
-    m_rootItem->setBrush(QBrush(Qt::white));
+    const auto oldPen = m_item->pen();
+    const auto oldBrush = m_item->rootBrush();
+    m_item->setPen(QPen(Qt::black));
+    m_item->setRootBrush(QBrush(Qt::white));
 
     QPainter painter(&generator);
     m_scene->render(&painter, generator.viewBoxF(), sceneRect);
 
-    m_rootItem->setPen(oldPen);
-    m_rootItem->setBrush(oldBrush);
+    m_item->setPen(oldPen);
+    m_item->setRootBrush(oldBrush);
 }
 
 void FlameGraph::showData()
@@ -1074,50 +1349,86 @@ void FlameGraph::showData()
         return;
     }
 
+    cancelBuild();
     setData(nullptr);
 
     m_buildingScene = true;
     auto bottomUpData = m_bottomUpData;
     auto topDownData = m_topDownData;
     const auto collapseRecursion = m_collapseRecursion;
-    auto type = m_costSource->currentData().value<int>();
-    auto threshold = m_costThreshold;
-    auto brushConfig = ::brushConfig(Settings::instance()->colorScheme());
-
-    QtConcurrent::run([showBottomUpData, bottomUpData, topDownData, type, threshold, brushConfig, collapseRecursion]() {
-        if (showBottomUpData) {
-            return parseData(bottomUpData.costs, type, bottomUpData.root.children, threshold, brushConfig,
-                             collapseRecursion);
-        } else {
-            return parseData(topDownData.inclusiveCosts, type, topDownData.root.children, threshold, brushConfig,
-                             collapseRecursion);
+
+    // the frames contain the costs of all types, switching the cost type or threshold only requires a new layout
+    m_buildFuture = QtConcurrent::run([showBottomUpData, bottomUpData, topDownData,
+                                       collapseRecursion](FlameGraphPromise& promise) {
+        auto frames = showBottomUpData
+            ? buildFrames(bottomUpData.costs, bottomUpData.root.children, collapseRecursion, promise)
+            : buildFrames(topDownData.inclusiveCosts, topDownData.root.children, collapseRecursion, promise);
+        if (frames) {
+            promise.addResult(std::move(frames));
+        }
+    });
+    m_buildFuture.then(this, [this, buildId = m_currentBuildId](std::shared_ptr<const FlameGraphFrames> frames) {
+        // the build may have finished right before it got canceled
+        if (buildId == m_currentBuildId) {
+            setData(std::move(frames));
         }
-    }).then(this, [this](FrameGraphicsItem* parsedData) { setData(parsedData); });
+    });
     updateNavigationActions();
 }
 
-void FlameGraph::setTooltipItem(const FrameGraphicsItem* item)
+void FlameGraph::cancelBuild()
+{
+    ++m_currentBuildId;
+    m_buildFuture.cancel();
+}
+
+void FlameGraph::updateCostType()
+{
+    if (!m_item) {
+        return;
+    }
+
+    m_item->setCostType(m_costSource->currentData().value<int>(), m_costThreshold,
+                        brushConfig(Settings::instance()->colorScheme()));
+    updateSearchResults();
+    if (isVisible()) {
+        selectFrame(m_selectionHistory.at(m_selectedItem));
+    }
+}
+
+int FlameGraph::frameAt(QPoint pos) const
 {
-    if (!item && m_selectedItem != -1 && m_selectionHistory.at(m_selectedItem)) {
-        item = m_selectionHistory.at(m_selectedItem);
+    if (!m_item) {
+        return -1;
+    }
+    return m_item->frameAt(m_item->mapFromScene(m_view->mapToScene(pos)));
+}
+
+void FlameGraph::setTooltipFrame(int frame)
+{
+    if (!m_item) {
+        frame = -1;
+    } else if (frame == -1 && m_selectedItem != -1) {
+        frame = m_selectionHistory.at(m_selectedItem);
         m_view->setCursor(Qt::ArrowCursor);
     } else {
         m_view->setCursor(Qt::PointingHandCursor);
     }
 
-    m_tooltipItem = item;
+    m_tooltipFrame = frame;
     updateTooltip();
 
-    if (item) {
-        emit selectSymbol(item->symbol());
+    if (frame != -1) {
+        emit selectSymbol(m_item->symbol(frame));
 
         const auto costAggregation = Settings::instance()->costAggregation();
         const auto skipFirstLevel = costAggregation != Settings::CostAggregation::BySymbol;
         QVector<Data::Symbol> stack;
         stack.reserve(32);
-        while (item && (item != m_rootItem && (!skipFirstLevel || item->parentItem() != m_rootItem))) {
-            stack.append(item->symbol());
-            item = static_cast<const FrameGraphicsItem*>(item->parentItem());
+        // the root frame is always the first one
+        while (frame > 0 && (!skipFirstLevel || m_item->parentFrame(frame) != 0)) {
+            stack.append(m_item->symbol(frame));
+            frame = m_item->parentFrame(frame);
         }
         emit selectStack(stack, m_showBottomUpData);
     }
@@ -1125,21 +1436,23 @@ void FlameGraph::setTooltipItem(const FrameGraphicsItem* item)
 
 void FlameGraph::updateTooltip()
 {
-    const auto text = m_tooltipItem ? m_tooltipItem->description() : QString();
+    const auto text = m_tooltipFrame != -1 ? m_item->description(m_tooltipFrame) : QString();
     m_displayLabel->setToolTip(text);
     m_displayLabel->setText(text);
 }
 
-void FlameGraph::setData(FrameGraphicsItem* rootItem)
+void FlameGraph::setData(std::shared_ptr<const FlameGraphFrames> frames)
 {
     m_scene->clear();
     m_buildingScene = false;
-    m_tooltipItem = nullptr;
-    m_rootItem = rootItem;
+    m_tooltipFrame = -1;
+    m_item = nullptr;
+    // discard pending searches for the previous item
+    ++m_currentSearchId;
     m_selectionHistory.clear();
-    m_selectionHistory.push_back(rootItem);
+    m_selectionHistory.push_back(0);
     m_selectedItem = 0;
-    if (!rootItem) {
+    if (!frames) {
         auto text = m_scene->addText(i18n("generating flame graph..."));
         m_view->centerOn(text);
         m_view->setCursor(Qt::BusyCursor);
@@ -1147,19 +1460,21 @@ void FlameGraph::setData(FrameGraphicsItem* rootItem)
     }
 
     m_view->setCursor(Qt::ArrowCursor);
-    // layouting needs a root item with a given height, the rest will be overwritten later
-    rootItem->setRect(0, 0, 800, m_view->fontMetrics().height() + 4);
-    m_scene->addItem(rootItem);
+    const auto scheme = KColorScheme(QPalette::Active);
+    m_item = new FlameGraphItem(std::move(frames), QPen(scheme.foreground().color()), scheme.background());
+    m_item->setCostType(m_costSource->currentData().value<int>(), m_costThreshold,
+                        brushConfig(Settings::instance()->colorScheme()));
+    m_scene->addItem(m_item);
 
     if (!m_search.isEmpty()) {
         setSearchValue(m_search, m_useRegex);
     }
     if (!m_hoveredStacks.isEmpty()) {
-        hoverStacks(rootItem, m_hoveredStacks);
+        hoverStacks();
     }
 
     if (isVisible()) {
-        selectItem(m_rootItem);
+        selectFrame(0);
     }
 
     emit canConvertToImageChanged();
@@ -1169,67 +1484,75 @@ void FlameGraph::selectItem(int item)
 {
     m_selectedItem = item;
     updateNavigationActions();
-    selectItem(m_selectionHistory.at(m_selectedItem));
+    selectFrame(m_selectionHistory.at(m_selectedItem));
 }
 
-void FlameGraph::selectItem(FrameGraphicsItem* item)
+void FlameGraph::selectFrame(int frame)
 {
-    if (!item) {
+    if (!m_item) {
         return;
     }
 
-    // scale item and its parents to the maximum available width
-    // also hide all siblings of the parent items
+    // scale the frame and its parents to the maximum available width
+    // and layout all frames below the selected one
     const auto padding = 8;
     const auto rootWidth = m_view->viewport()->width() - (padding * 2)
         - (m_view->verticalScrollBar()->isVisible() ? 0 : m_view->verticalScrollBar()->sizeHint().width());
-    auto parent = item;
-    while (parent) {
-        auto rect = parent->rect();
-        rect.setLeft(0);
-        rect.setWidth(rootWidth);
-        parent->setRect(rect);
-        if (parent->parentItem()) {
-            const auto children = parent->parentItem()->childItems();
-            for (auto sibling : children) {
-                sibling->setVisible(sibling == parent);
-            }
-        }
-        parent = static_cast<FrameGraphicsItem*>(parent->parentItem());
-    }
-
-    // then layout all items below the selected on
-    layoutItems(item);
+    m_item->layout(frame, rootWidth, m_view->fontMetrics().height() + 4);
+    m_item->setSelectedFrame(frame);
 
     // Triggers a refresh of the scene's bounding rect without going via the
     // event loop. This makes the centerOn call below work as expected in all cases.
     m_scene->sceneRect();
 
     // and make sure it's visible
-    m_view->centerOn(item);
+    m_view->centerOn(m_item->mapToScene(m_item->frameRect(frame).center()));
 
-    setTooltipItem(item);
+    setTooltipFrame(frame);
 }
 
 void FlameGraph::setSearchValue(const QString& value, bool useRegex)
 {
-    if (!m_rootItem) {
+    if (!m_item) {
         return;
     }
 
     m_search = value;
     m_useRegex = useRegex;
+    const auto searchId = ++m_currentSearchId;
+    if (value.isEmpty()) {
+        m_item->setSearchMatches({});
+        updateSearchResults();
+        return;
+    }
+
+    // match every unique symbol once in the background, instead of every frame on the GUI thread
     auto regex = useRegex ? value : QRegularExpression::escape(value);
-    auto match = applySearch(m_rootItem, QRegularExpression(regex, QRegularExpression::CaseInsensitiveOption));
+    QtConcurrent::run([symbolTable = m_item->symbolTable(),
+                       pattern = QRegularExpression(regex, QRegularExpression::CaseInsensitiveOption)]() {
+        return Data::SymbolMatches(symbolTable, pattern);
+    }).then(this, [this, searchId](Data::SymbolMatches symbolMatches) {
+        // the search or the item may have changed in the meantime
+        if (searchId != m_currentSearchId || !m_item) {
+            return;
+        }
+        m_item->setSearchMatches(std::move(symbolMatches));
+        updateSearchResults();
+    });
+}
 
-    if (value.isEmpty()) {
+void FlameGraph::updateSearchResults()
+{
+    if (!m_item || m_search.isEmpty()) {
         m_searchResultsLabel->hide();
-    } else {
-        m_searchResultsLabel->setText(
-            i18n("%1 (%2% of total of %3) aggregated costs matched by search.", Util::formatCost(match.directCost),
-                 Util::formatCostRelative(match.directCost, m_rootItem->cost()), m_rootItem->cost()));
-        m_searchResultsLabel->show();
+        return;
     }
+
+    const auto match = m_item->searchResults();
+    m_searchResultsLabel->setText(i18n("%1 (%2% of total of %3) aggregated costs matched by search.",
+                                       Util::formatCost(match.directCost),
+                                       Util::formatCostRelative(match.directCost, m_item->cost(0)), m_item->cost(0)));
+    m_searchResultsLabel->show();
 }
 
 void FlameGraph::navigateBack()
@@ -1257,5 +1580,5 @@ void FlameGraph::updateNavigationActions()
 
 bool FlameGraph::canConvertToImage() const
 {
-    return m_rootItem != nullptr;
+    return m_item != nullptr;
 }
@@ -7,11 +7,14 @@
 
 #pragma once
 
+#include <QFuture>
 #include <QVector>
 #include <QWidget>
 
 #include <models/data.h>
 
+#include <memory>
+
 class QGraphicsScene;
 class QGraphicsView;
 class QComboBox;
@@ -20,7 +23,8 @@ class QLineEdit;
 
 class KSqueezedTextLabel;
 
-class FrameGraphicsItem;
+class FlameGraphItem;
+struct FlameGraphFrames;
 class FilterAndZoomStack;
 
 class FlameGraph : public QWidget
@@ -43,7 +47,6 @@ public:
     bool eventFilter(QObject* object, QEvent* event) override;
 
 private slots:
-    void setData(FrameGraphicsItem* rootItem);
     void setSearchValue(const QString& value, bool useRegex);
     void navigateBack();
     void navigateForward();
@@ -58,11 +61,18 @@ signals:
     void canConvertToImageChanged();
 
 private:
-    void setTooltipItem(const FrameGraphicsItem* item);
+    // returns the frame below @p pos in viewport coordinates, or -1
+    int frameAt(QPoint pos) const;
+    void setTooltipFrame(int frame);
     void updateTooltip();
+    void updateSearchResults();
     void showData();
+    void cancelBuild();
+    void updateCostType();
+    void setData(std::shared_ptr<const FlameGraphFrames> frames);
     void selectItem(int item);
-    void selectItem(FrameGraphicsItem* item);
+    void selectFrame(int frame);
+    void hoverStacks();
     void updateNavigationActions();
     void rebuild();
 
@@ -78,9 +88,15 @@ private:
     QAction* m_forwardAction = nullptr;
     QAction* m_backAction = nullptr;
     QAction* m_resetAction = nullptr;
-    const FrameGraphicsItem* m_tooltipItem = nullptr;
-    FrameGraphicsItem* m_rootItem = nullptr;
-    QVector<FrameGraphicsItem*> m_selectionHistory;
+    QFuture<std::shared_ptr<const FlameGraphFrames>> m_buildFuture;
+    // bumped to discard the result of outdated builds
+    uint m_currentBuildId = 0;
+    // bumped to discard the matches of outdated searches
+    uint m_currentSearchId = 0;
+    FlameGraphItem* m_item = nullptr;
+    int m_tooltipFrame = -1;
+    // frames of m_item, the root frame is always the first one
+    QVector<int> m_selectionHistory;
     int m_selectedItem = -1;
     int m_minRootWidth = 0;
     bool m_showBottomUpData = false;
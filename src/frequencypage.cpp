@@ -16,7 +16,14 @@
 
 #include <KColorScheme>
 #include <QDebug>
+#include <QSignalBlocker>
+#include <QTimer>
+#include <QtConcurrent/QtConcurrentMap>
+#include <QtConcurrent/QtConcurrentRun>
 
+#include <numeric>
+
+#include "models/frequencypyramid.h"
 #include "parsers/perf/perfparser.h"
 #include "ui_frequencypage.h"
 #include "util.h"
@@ -27,6 +34,12 @@ struct PlotData
     quint64 applicationStartTime = 0;
 };
 
+struct CoreFrequencies
+{
+    std::shared_ptr<const FrequencyPyramid> pyramid;
+    double sumValues = 0;
+};
+
 class TimeAxis : public QCPAxisTicker
 {
 public:
@@ -38,14 +51,42 @@ protected:
         return Util::formatTimeString(tick);
     }
 };
+
+void setGraphData(QCPGraph* graph, const QVector<Data::FrequencyData>& points, quint64 timeOffset)
+{
+    QVector<double> times(points.size());
+    QVector<double> costs(points.size());
+    for (int i = 0, c = points.size(); i < c; ++i) {
+        times[i] = static_cast<double>(points[i].time) - timeOffset;
+        costs[i] = points[i].cost;
+    }
+    graph->setData(times, costs, true);
+}
+
+int plotWidth(const QCustomPlot* plot)
+{
+    // the plot might not have been laid out yet
+    return std::max(100, plot->axisRect()->width());
+}
 }
 
 FrequencyPage::FrequencyPage(PerfParser* parser, QWidget* parent)
     : QWidget(parent)
     , m_plot(new QCustomPlot(this))
     , m_page(std::make_unique<Ui::FrequencyPage>())
+    , m_decimationTimer(new QTimer(this))
 {
     m_plot->axisRect()->setupFullAxesBox(true);
+    m_plot->setInteractions(QCP::iRangeDrag | QCP::iRangeZoom);
+    m_plot->axisRect()->setRangeDrag(Qt::Horizontal);
+    m_plot->axisRect()->setRangeZoom(Qt::Horizontal);
+
+    // only decimate once the user stopped zooming or panning for a moment
+    m_decimationTimer->setSingleShot(true);
+    m_decimationTimer->setInterval(50);
+    connect(m_decimationTimer, &QTimer::timeout, this, &FrequencyPage::updateDecimation);
+    connect(m_plot->xAxis, qOverload<const QCPRange&>(&QCPAxis::rangeChanged), m_decimationTimer,
+            qOverload<>(&QTimer::start));
 
     updateColors();
 
@@ -59,21 +100,10 @@ FrequencyPage::FrequencyPage(PerfParser* parser, QWidget* parent)
     connect(parser, &PerfParser::summaryDataAvailable,
             [plotData](const Data::Summary& data) { plotData->applicationStartTime = data.applicationTime.start; });
 
-    connect(parser, &PerfParser::frequencyDataAvailable, this, [this](const Data::FrequencyResults& results) {
-        m_results = results;
-
-        m_page->costSelectionCombobox->clear();
-
-        QSet<QString> costs;
-        for (const auto& coreData : std::as_const(m_results.cores)) {
-            for (const auto& costData : coreData.costs) {
-                if (!costs.contains(costData.costName)) {
-                    costs.insert(costData.costName);
-                    m_page->costSelectionCombobox->addItem(costData.costName);
-                }
-            }
-        }
-    });
+    for (quint64 windowSize : {1000000ull, 10000000ull, 100000000ull, 1000000000ull}) {
+        m_page->windowSize->addItem(Util::formatTimeString(windowSize, true), windowSize);
+    }
+    m_page->windowSize->setCurrentIndex(1);
 
     auto updateYAxis = [this]() {
         const auto hideOutliers = m_page->hideOutliers->isChecked();
@@ -89,19 +119,47 @@ FrequencyPage::FrequencyPage(PerfParser* parser, QWidget* parent)
     };
 
     auto updateGraphs = [this, plotData, updateYAxis]() {
+        // drop results of a decimation that is still running for the old graphs
+        ++m_decimationId;
+        m_series.clear();
         m_plot->clearGraphs();
-        const auto averagingWindowSize = m_page->averagingWindowSize->value();
-        const auto selectedCost = m_page->costSelectionCombobox->currentText();
-        const auto numCores = m_results.cores.size();
-        quint32 core = 0;
+        m_plot->replot(QCustomPlot::rpQueuedReplot);
+        m_timeOffset = plotData->applicationStartTime;
         m_upperWithoutOutliers = 0;
 
-        double sumCost = 0;
-        double numEntries = 0;
+        const auto costId = m_page->costSelectionCombobox->currentData().toInt();
+        const auto costName = m_page->costSelectionCombobox->currentText();
+        const auto windowSize = m_page->windowSize->currentData().value<quint64>();
+        if (m_page->costSelectionCombobox->currentIndex() == -1 || !windowSize) {
+            return;
+        }
+
+        // the frequencies of every core are computed in parallel from their events
+        const auto frequencyId = ++m_frequencyId;
+        auto future = QtConcurrent::mapped(m_results.cpus, [costId, windowSize](const Data::CpuEvents& cpu) {
+            CoreFrequencies frequencies;
+            auto values = Data::windowedFrequencies(cpu.events, costId, windowSize);
+            frequencies.sumValues = std::accumulate(
+                values.cbegin(), values.cend(), 0.,
+                [](double sum, const Data::FrequencyData& value) { return sum + value.cost; });
+            frequencies.pyramid = std::make_shared<const FrequencyPyramid>(std::move(values));
+            return frequencies;
+        });
+
+        future.then(this, [this, frequencyId, costName, updateYAxis](const QFuture<CoreFrequencies>& frequencies) {
+            if (frequencyId != m_frequencyId) {
+                return;
+            }
+
+            const auto results = frequencies.results();
+            const auto numCores = results.size();
+            double sumValues = 0;
+            qsizetype numValues = 0;
 
-        for (const auto& coreData : std::as_const(m_results.cores)) {
-            for (const auto& costData : coreData.costs) {
-                if (costData.costName != selectedCost) {
+            for (int core = 0; core < numCores; ++core) {
+                const auto& pyramid = results[core].pyramid;
+                const auto& values = pyramid->values();
+                if (values.isEmpty()) {
                     continue;
                 }
 
@@ -113,47 +171,53 @@ FrequencyPage::FrequencyPage(PerfParser* parser, QWidget* parent)
                     QColor::fromHsv(static_cast<int>(255. * (static_cast<float>(core) / numCores)), 255, 255, 150);
                 graph->setScatterStyle(QCPScatterStyle(QCPScatterStyle::ssSquare, color, color, 4));
                 graph->setAdaptiveSampling(false);
-                graph->setName(QLatin1String("%1 (CPU #%2)").arg(costData.costName, QString::number(core)));
+                graph->setName(QLatin1String("%1 (CPU #%2)").arg(costName, QString::number(core)));
                 graph->addToLegend();
                 graph->setVisible(true);
 
-                const auto numValues = static_cast<int>(costData.values.size());
-                const auto valuesStart = costData.values.begin();
-                QVector<double> times((numValues + averagingWindowSize - 1) / averagingWindowSize);
-                QVector<double> costs(times.size());
-                for (int i = 0, j = 0; i < numValues; ++j, i += averagingWindowSize) {
-                    const auto averageWindowStart = std::next(valuesStart, i);
-                    const auto windowEndIndex = std::min(numValues, i + averagingWindowSize);
-                    const auto averageWindowEnd = std::next(valuesStart, windowEndIndex);
-                    const auto actualWindowSize = windowEndIndex - i;
-                    const auto value = std::accumulate(averageWindowStart, averageWindowEnd, Data::FrequencyData {},
-                                                       [](Data::FrequencyData lhs, Data::FrequencyData rhs) {
-                                                           lhs.time += rhs.time;
-                                                           lhs.cost += rhs.cost;
-                                                           return lhs;
-                                                       });
-                    const auto time =
-                        (static_cast<double>(value.time) / actualWindowSize) - plotData->applicationStartTime;
-                    times[j] = time;
-                    costs[j] = value.cost / actualWindowSize;
-                    numEntries += actualWindowSize;
-                    sumCost += value.cost;
-                }
-                graph->setData(times, costs, true);
-            }
+                // only plot as many points as can be told apart, zooming in gives more details
+                setGraphData(graph, pyramid->decimate(values.first().time, values.last().time, plotWidth(m_plot)),
+                             m_timeOffset);
+                m_series.append({graph, pyramid});
 
-            ++core;
-        }
-        m_plot->xAxis->rescale();
+                sumValues += results[core].sumValues;
+                numValues += values.size();
+            }
+            m_plot->xAxis->rescale();
 
-        const auto avgCost = sumCost / numEntries;
-        m_upperWithoutOutliers = avgCost * 1.1;
+            if (numValues) {
+                const auto avgCost = sumValues / numValues;
+                m_upperWithoutOutliers = avgCost * 1.1;
+            }
 
-        updateYAxis();
+            updateYAxis();
+        });
     };
 
+    connect(parser, &PerfParser::eventsAvailable, this, [this, updateGraphs](const Data::EventResults& results) {
+        m_results = results;
+
+        // keep the selected cost when the data got filtered
+        const auto selectedCost = m_page->costSelectionCombobox->currentText();
+        {
+            const QSignalBlocker blocker(m_page->costSelectionCombobox);
+            m_page->costSelectionCombobox->clear();
+            for (int costId = 0, c = m_results.totalCosts.size(); costId < c; ++costId) {
+                if (costId == m_results.offCpuTimeCostId || costId == m_results.lostEventCostId
+                    || !m_results.totalCosts[costId].sampleCount) {
+                    continue;
+                }
+                m_page->costSelectionCombobox->addItem(m_results.totalCosts[costId].label, costId);
+            }
+            m_page->costSelectionCombobox->setCurrentIndex(
+                std::max(0, m_page->costSelectionCombobox->findText(selectedCost)));
+        }
+
+        updateGraphs();
+    });
+
     connect(m_page->costSelectionCombobox, qOverload<int>(&QComboBox::currentIndexChanged), this, updateGraphs);
-    connect(m_page->averagingWindowSize, qOverload<int>(&QSpinBox::valueChanged), this, updateGraphs);
+    connect(m_page->windowSize, qOverload<int>(&QComboBox::currentIndexChanged), this, updateGraphs);
     connect(m_page->hideOutliers, &QCheckBox::toggled, this, updateYAxis);
 
     m_plot->xAxis->setLabel(tr("Time"));
@@ -164,6 +228,45 @@ FrequencyPage::FrequencyPage(PerfParser* parser, QWidget* parent)
 
 FrequencyPage::~FrequencyPage() = default;
 
+void FrequencyPage::updateDecimation()
+{
+    if (m_series.isEmpty()) {
+        return;
+    }
+
+    // also include the area next to the visible range, so that panning doesn't immediately show gaps
+    const auto range = m_plot->xAxis->range();
+    auto toTime = [this](double time) { return static_cast<quint64>(std::max(0., time + m_timeOffset)); };
+    const auto start = toTime(range.lower - range.size());
+    const auto end = toTime(range.upper + range.size());
+    const auto numPixels = plotWidth(m_plot) * 3;
+
+    QVector<std::shared_ptr<const FrequencyPyramid>> pyramids;
+    pyramids.reserve(m_series.size());
+    for (const auto& series : std::as_const(m_series)) {
+        pyramids.append(series.pyramid);
+    }
+
+    const auto decimationId = ++m_decimationId;
+    auto future = QtConcurrent::run([pyramids, start, end, numPixels]() {
+        QVector<QVector<Data::FrequencyData>> points;
+        points.reserve(pyramids.size());
+        for (const auto& pyramid : pyramids) {
+            points.append(pyramid->decimate(start, end, numPixels));
+        }
+        return points;
+    });
+    future.then(this, [this, decimationId](const QVector<QVector<Data::FrequencyData>>& points) {
+        if (decimationId != m_decimationId) {
+            return;
+        }
+        for (int i = 0, c = std::min(points.size(), m_series.size()); i < c; ++i) {
+            setGraphData(m_series[i].graph, points[i], m_timeOffset);
+        }
+        m_plot->replot(QCustomPlot::rpQueuedReplot);
+    });
+}
+
 void FrequencyPage::changeEvent(QEvent* event)
 {
     if (event->type() == QEvent::PaletteChange) {
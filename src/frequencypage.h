@@ -14,8 +14,11 @@
 
 #include <memory>
 
+class FrequencyPyramid;
 class PerfParser;
+class QCPGraph;
 class QCustomPlot;
+class QTimer;
 
 namespace Ui {
 class FrequencyPage;
@@ -33,10 +36,24 @@ protected:
 
 private:
     void updateColors();
+    // recompute the points of all graphs for the current x axis range in the background
+    void updateDecimation();
+
+    struct Series
+    {
+        QCPGraph* graph = nullptr;
+        std::shared_ptr<const FrequencyPyramid> pyramid;
+    };
 
     QCustomPlot* m_plot = nullptr;
     std::unique_ptr<Ui::FrequencyPage> m_page;
-    Data::FrequencyResults m_results;
+    Data::EventResults m_results;
+    QVector<Series> m_series;
+    // the time that is shown as zero on the x axis
+    quint64 m_timeOffset = 0;
+    QTimer* m_decimationTimer = nullptr;
+    uint m_decimationId = 0;
+    uint m_frequencyId = 0;
 
     double m_upperWithoutOutliers = 0;
 };
@@ -10,8 +10,10 @@
 
 #include "callercalleemodel.h"
 #include "data.h"
+#include "treemodel.h"
 
 #include <QRegularExpression>
+#include <QtConcurrent/QtConcurrentRun>
 
 namespace {
 bool matchImpl(const QRegularExpression& pattern, const QString& haystack)
@@ -20,12 +22,65 @@ bool matchImpl(const QRegularExpression& pattern, const QString& haystack)
 }
 }
 
-namespace CallerCalleeProxyDetail {
-bool match(const QSortFilterProxyModel* proxy, const Data::Symbol& symbol)
+SymbolFilterProxy::SymbolFilterProxy(QObject* parent)
+    : QSortFilterProxyModel(parent)
 {
-    const auto pattern = proxy->filterRegularExpression();
+}
+
+SymbolFilterProxy::~SymbolFilterProxy() = default;
+
+void SymbolFilterProxy::setSymbolTable(const Data::SymbolTable& symbolTable)
+{
+    m_symbolTable = symbolTable;
+    if (!m_search.isEmpty()) {
+        setSearch(m_search);
+    }
+}
+
+void SymbolFilterProxy::setSearch(const QString& search)
+{
+    m_search = search;
+    const auto searchId = ++m_currentSearchId;
+
+    // searches must see all nodes, not only the ones that got fetched so far
+    if (auto* treeModel = qobject_cast<AbstractTreeModel*>(sourceModel())) {
+        treeModel->setFetchAll(!search.isEmpty());
+    }
+
+    if (search.isEmpty() || m_symbolTable.symbols.isEmpty()) {
+        m_symbolMatches = {};
+        setFilterRegularExpression(search);
+        return;
+    }
 
-    return matchImpl(pattern, symbol.symbol) || matchImpl(pattern, symbol.binary);
+    const auto options = filterCaseSensitivity() == Qt::CaseInsensitive ? QRegularExpression::CaseInsensitiveOption
+                                                                         : QRegularExpression::NoPatternOption;
+    QtConcurrent::run([symbolTable = m_symbolTable, pattern = QRegularExpression(search, options)]() {
+        return Data::SymbolMatches(symbolTable, pattern);
+    }).then(this, [this, searchId](Data::SymbolMatches symbolMatches) {
+        // ignore outdated searches
+        if (searchId != m_currentSearchId) {
+            return;
+        }
+        m_symbolMatches = std::move(symbolMatches);
+        setFilterRegularExpression(m_symbolMatches.pattern());
+    });
+}
+
+bool SymbolFilterProxy::matches(const Data::Symbol& symbol) const
+{
+    // the filter may change before the matches for it are available
+    const auto pattern = filterRegularExpression();
+    if (m_symbolMatches.isActive() && m_symbolMatches.pattern() == pattern) {
+        return m_symbolMatches.matches(symbol);
+    }
+    return Data::SymbolMatches::matches(symbol, pattern);
+}
+
+namespace CallerCalleeProxyDetail {
+bool match(const SymbolFilterProxy* proxy, const Data::Symbol& symbol)
+{
+    return proxy->matches(symbol);
 }
 
 bool match(const QSortFilterProxyModel* proxy, const Data::FileLine& fileLine)
@@ -57,5 +112,5 @@ bool SourceMapProxy::lessThan(const QModelIndex& source_left, const QModelIndex&
         const auto right = source_right.data(SourceMapModel::SortRole).value<Data::FileLine>();
         return left < right;
     }
-    return QSortFilterProxyModel::lessThan(source_left, source_right);
+    return CallerCalleeProxy<SourceMapModel>::lessThan(source_left, source_right);
 }
@@ -10,13 +10,37 @@
 
 #include <QSortFilterProxyModel>
 
-namespace Data {
-struct Symbol;
-struct FileLine;
-}
+#include "data.h"
+
+/**
+ * Base class for proxies that filter rows by their symbol.
+ *
+ * Once a symbol table is set, searches get matched against every unique symbol in the background. Rows then only
+ * need to look up the result for their symbol, instead of matching the same symbol again for every row.
+ */
+class SymbolFilterProxy : public QSortFilterProxyModel
+{
+    Q_OBJECT
+public:
+    explicit SymbolFilterProxy(QObject* parent = nullptr);
+    ~SymbolFilterProxy() override;
+
+    void setSymbolTable(const Data::SymbolTable& symbolTable);
+
+    // like setFilterRegularExpression, but the filter gets applied once all symbols are matched
+    void setSearch(const QString& search);
+
+    bool matches(const Data::Symbol& symbol) const;
+
+private:
+    Data::SymbolTable m_symbolTable;
+    Data::SymbolMatches m_symbolMatches;
+    QString m_search;
+    uint m_currentSearchId = 0;
+};
 
 namespace CallerCalleeProxyDetail {
-bool match(const QSortFilterProxyModel* proxy, const Data::Symbol& symbol);
+bool match(const SymbolFilterProxy* proxy, const Data::Symbol& symbol);
 bool match(const QSortFilterProxyModel* proxy, const Data::FileLine& fileLine);
 bool match(const QSortFilterProxyModel* proxy, const QString& file);
 }
@@ -24,11 +48,11 @@ bool match(const QSortFilterProxyModel* proxy, const QString& file);
 class SourceMapModel;
 
 template<typename Model>
-class CallerCalleeProxy : public QSortFilterProxyModel
+class CallerCalleeProxy : public SymbolFilterProxy
 {
 public:
     explicit CallerCalleeProxy(QObject* parent = nullptr)
-        : QSortFilterProxyModel(parent)
+        : SymbolFilterProxy(parent)
     {
         setRecursiveFilteringEnabled(true);
         setDynamicSortFilter(true);
@@ -46,6 +70,18 @@ protected:
 
         return CallerCalleeProxyDetail::match(this, key);
     }
+
+    bool lessThan(const QModelIndex& source_left, const QModelIndex& source_right) const override
+    {
+        const auto column = source_left.column();
+        if (column >= Model::NUM_BASE_COLUMNS && column == source_right.column()) {
+            const auto* model = qobject_cast<Model*>(sourceModel());
+            Q_ASSERT(model);
+            // higher ranks mean lower costs
+            return model->costRank(source_left.row(), column) > model->costRank(source_right.row(), column);
+        }
+        return SymbolFilterProxy::lessThan(source_left, source_right);
+    }
 };
 
 class SourceMapProxy : public CallerCalleeProxy<SourceMapModel>
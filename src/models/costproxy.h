@@ -13,11 +13,11 @@
 #include "callercalleeproxy.h"
 
 template<typename Model>
-class CostProxy : public QSortFilterProxyModel
+class CostProxy : public SymbolFilterProxy
 {
 public:
     explicit CostProxy(QObject* parent = nullptr)
-        : QSortFilterProxyModel(parent)
+        : SymbolFilterProxy(parent)
     {
         setRecursiveFilteringEnabled(true);
         setDynamicSortFilter(true);
@@ -38,4 +38,14 @@ protected:
 
         return CallerCalleeProxyDetail::match(this, item->symbol);
     }
+
+    bool lessThan(const QModelIndex& source_left, const QModelIndex& source_right) const override
+    {
+        if (source_left.column() >= Model::NUM_BASE_COLUMNS && source_left.column() == source_right.column()) {
+            const auto* model = qobject_cast<Model*>(sourceModel());
+            Q_ASSERT(model);
+            return model->costLessThan(source_left, source_right);
+        }
+        return SymbolFilterProxy::lessThan(source_left, source_right);
+    }
 };
@@ -8,24 +8,61 @@
 #include "data.h"
 
 #include <QDebug>
+#include <QFuture>
 #include <QSet>
+#include <QThread>
+#include <QtConcurrent/QtConcurrentRun>
+
+#include <deque>
 
 using namespace Data;
 
 namespace {
 
-ItemCost buildTopDownResult(const BottomUp& bottomUpData, const Costs& bottomUpCosts, TopDown* topDownData,
-                            Costs* inclusiveCosts, Costs* selfCosts, quint32* maxId, bool skipFirstLevel)
+using BottomUpIterator = QVector<BottomUp>::const_iterator;
+
+// per-depth buffers for the costs of the children of a node, reused for all nodes on that depth
+// a deque keeps references to existing buffers valid while deeper levels get added
+using CostScratch = std::deque<ItemCost>;
+
+ItemCost& scratchCost(CostScratch* scratch, int depth, int numTypes)
+{
+    if (scratch->size() <= static_cast<std::size_t>(depth)) {
+        scratch->emplace_back(numTypes);
+    }
+    auto& cost = (*scratch)[depth];
+    for (int i = 0; i < numTypes; ++i) {
+        cost[i] = 0;
+    }
+    return cost;
+}
+
+// turns @p childCost into the self cost of @p row and adds its inclusive cost to @p totalCost
+// returns true when the row is (partially) a leaf, i.e. its self cost isn't zero
+bool toSelfCost(ItemCost& childCost, const BottomUp& row, const Costs& bottomUpCosts, ItemCost* totalCost)
+{
+    qint64 sum = 0;
+    for (int i = 0, c = bottomUpCosts.numTypes(); i < c; ++i) {
+        const auto rowCost = bottomUpCosts.cost(i, row.id);
+        (*totalCost)[i] += rowCost;
+        childCost[i] = rowCost - childCost[i];
+        sum += childCost[i];
+    }
+    return sum != 0;
+}
+
+// adds the inclusive bottom-up costs of the rows in [@p begin, @p end) to @p totalCost
+void buildTopDownResult(BottomUpIterator begin, BottomUpIterator end, const Costs& bottomUpCosts,
+                        TopDown* topDownData, Costs* inclusiveCosts, Costs* selfCosts, quint32* maxId,
+                        bool skipFirstLevel, ItemCost* totalCost, CostScratch* scratch, int depth)
 {
-    ItemCost totalCost;
-    totalCost.resize(bottomUpCosts.numTypes(), 0);
-    for (const auto& row : bottomUpData.children) {
+    for (auto it = begin; it != end; ++it) {
+        const auto& row = *it;
         // recurse and find the cost attributed to children
-        const auto childCost =
-            buildTopDownResult(row, bottomUpCosts, topDownData, inclusiveCosts, selfCosts, maxId, skipFirstLevel);
-        const auto rowCost = bottomUpCosts.itemCost(row.id);
-        const auto diff = rowCost - childCost;
-        if (diff.sum() != 0) {
+        auto& diff = scratchCost(scratch, depth, bottomUpCosts.numTypes());
+        buildTopDownResult(row.children.cbegin(), row.children.cend(), bottomUpCosts, topDownData, inclusiveCosts,
+                           selfCosts, maxId, skipFirstLevel, &diff, scratch, depth + 1);
+        if (toSelfCost(diff, row, bottomUpCosts, totalCost)) {
             // this row is (partially) a leaf
             // bubble up the parent chain to build a top-down tree
             auto node = &row;
@@ -47,9 +84,127 @@ ItemCost buildTopDownResult(const BottomUp& bottomUpData, const Costs& bottomUpC
                 node = node->parent;
             }
         }
-        totalCost += rowCost;
     }
-    return totalCost;
+}
+
+void buildTopDownResult(BottomUpIterator begin, BottomUpIterator end, const Costs& bottomUpCosts,
+                        TopDown* topDownData, Costs* inclusiveCosts, Costs* selfCosts, quint32* maxId,
+                        bool skipFirstLevel)
+{
+    ItemCost totalCost(bottomUpCosts.numTypes());
+    CostScratch scratch;
+    buildTopDownResult(begin, end, bottomUpCosts, topDownData, inclusiveCosts, selfCosts, maxId, skipFirstLevel,
+                       &totalCost, &scratch, 0);
+}
+
+// builds the top-down tree for the given range of top-level bottom-up nodes
+TopDownResults buildPartialTopDownResult(BottomUpIterator begin, BottomUpIterator end,
+                                         const BottomUpResults& bottomUpData, bool skipFirstLevel)
+{
+    TopDownResults results;
+    results.selfCosts.initializeCostsFrom(bottomUpData.costs);
+    results.inclusiveCosts.initializeCostsFrom(bottomUpData.costs);
+    quint32 maxId = 0;
+    if (skipFirstLevel) {
+        for (auto it = begin; it != end; ++it) {
+            const auto& bottomUpGroup = *it;
+            // manually copy the first level
+            auto topDownGroup = results.root.entryForSymbol(bottomUpGroup.symbol, &maxId);
+            // then traverse the children as separate trees basically
+            buildTopDownResult(bottomUpGroup.children.cbegin(), bottomUpGroup.children.cend(), bottomUpData.costs,
+                               topDownGroup, &results.inclusiveCosts, &results.selfCosts, &maxId, true);
+            // finally manually sum up the inclusive costs
+            for (const auto& child : std::as_const(topDownGroup->children)) {
+                results.inclusiveCosts.add(topDownGroup->id, results.inclusiveCosts, child.id);
+            }
+        }
+    } else {
+        buildTopDownResult(begin, end, bottomUpData.costs, &results.root, &results.inclusiveCosts, &results.selfCosts,
+                           &maxId, false);
+    }
+    return results;
+}
+
+// merges the partial top-down tree @p source into @p target, matching nodes by symbol
+void mergeTopDownResult(const TopDown& source, const TopDownResults& sourceResults, TopDown* target,
+                        TopDownResults* targetResults, quint32* maxId)
+{
+    for (const auto& child : source.children) {
+        auto frame = target->entryForSymbol(child.symbol, maxId);
+        targetResults->inclusiveCosts.add(frame->id, sourceResults.inclusiveCosts, child.id);
+        targetResults->selfCosts.add(frame->id, sourceResults.selfCosts, child.id);
+        mergeTopDownResult(child, sourceResults, frame, targetResults, maxId);
+    }
+}
+
+quint32 countNodes(const TopDown& node)
+{
+    quint32 count = node.children.size();
+    for (const auto& child : node.children) {
+        count += countNodes(child);
+    }
+    return count;
+}
+
+// merges neighboring partial results pairwise in parallel until only one is left
+// this keeps the order of the chunks, so the tree is the same as when merging serially
+TopDownResults mergeTopDownResults(QVector<TopDownResults> partialResults)
+{
+    while (partialResults.size() > 1) {
+        const int numMerges = partialResults.size() / 2;
+        auto* data = partialResults.data();
+
+        QVector<QFuture<void>> futures;
+        futures.reserve(numMerges);
+        for (int i = 0; i < numMerges; ++i) {
+            futures.append(QtConcurrent::run([target = &data[2 * i], source = &data[2 * i + 1]]() {
+                quint32 maxId = countNodes(target->root);
+                mergeTopDownResult(source->root, *source, &target->root, target, &maxId);
+            }));
+        }
+        for (auto& future : futures) {
+            future.waitForFinished();
+        }
+
+        // the first merge result is already in place
+        for (int i = 1; i < numMerges; ++i) {
+            data[i] = std::move(data[2 * i]);
+        }
+        if (partialResults.size() % 2) {
+            data[numMerges] = std::move(partialResults.last());
+            partialResults.resize(numMerges + 1);
+        } else {
+            partialResults.resize(numMerges);
+        }
+    }
+    return std::move(partialResults.first());
+}
+
+// runs @p job in parallel for roughly equally sized chunks of @p numItems items
+// the results of the jobs are returned in order of the chunks
+template<typename Job>
+auto runChunked(int numItems, const Job& job) -> QVector<decltype(job(0, 0))>
+{
+    using Result = decltype(job(0, 0));
+    const int numChunks = std::min(numItems, QThread::idealThreadCount());
+    if (numChunks <= 1) {
+        return {job(0, numItems)};
+    }
+
+    QVector<QFuture<Result>> futures;
+    futures.reserve(numChunks);
+    for (int i = 0; i < numChunks; ++i) {
+        const int chunkBegin = numItems * i / numChunks;
+        const int chunkEnd = numItems * (i + 1) / numChunks;
+        futures.append(QtConcurrent::run([&job, chunkBegin, chunkEnd]() { return job(chunkBegin, chunkEnd); }));
+    }
+
+    QVector<Result> results;
+    results.reserve(numChunks);
+    for (auto& future : futures) {
+        results.append(future.result());
+    }
+    return results;
 }
 
 void add(ItemCost& lhs, const ItemCost& rhs)
@@ -62,16 +217,15 @@ void add(ItemCost& lhs, const ItemCost& rhs)
     }
 }
 
-ItemCost buildCallerCalleeResult(const BottomUp& data, const Costs& bottomUpCosts, CallerCalleeResults* results)
+// adds the inclusive bottom-up costs of the children of @p data to @p totalCost
+void buildCallerCalleeResult(const BottomUp& data, const Costs& bottomUpCosts, CallerCalleeResults* results,
+                             ItemCost* totalCost, CostScratch* scratch, int depth)
 {
-    ItemCost totalCost;
-    totalCost.resize(bottomUpCosts.numTypes(), 0);
     for (const auto& row : data.children) {
         // recurse to find a leaf
-        const auto childCost = buildCallerCalleeResult(row, bottomUpCosts, results);
-        const auto rowCost = bottomUpCosts.itemCost(row.id);
-        const auto diff = rowCost - childCost;
-        if (diff.sum() != 0) {
+        auto& diff = scratchCost(scratch, depth, bottomUpCosts.numTypes());
+        buildCallerCalleeResult(row, bottomUpCosts, results, &diff, scratch, depth + 1);
+        if (toSelfCost(diff, row, bottomUpCosts, totalCost)) {
             // this row is (partially) a leaf
 
             // leaf node found, bubble up the parent chain to add cost for all frames
@@ -114,9 +268,14 @@ ItemCost buildCallerCalleeResult(const BottomUp& data, const Costs& bottomUpCost
                 lastEntry = &entry;
             }
         }
-        totalCost += rowCost;
     }
-    return totalCost;
+}
+
+void buildCallerCalleeResult(const BottomUp& data, const Costs& bottomUpCosts, CallerCalleeResults* results)
+{
+    ItemCost totalCost(bottomUpCosts.numTypes());
+    CostScratch scratch;
+    buildCallerCalleeResult(data, bottomUpCosts, results, &totalCost, &scratch, 0);
 }
 
 int findSameDepth(QStringView str, int offset, QChar ch, bool returnNext = false)
@@ -258,27 +417,29 @@ QString prettifySymbol(QStringView str)
     return result;
 }
 
-void buildPerLibrary(const TopDown* node, PerLibraryResults& results, QHash<QString, int>& pathToResultIndex,
-                     const Costs& costs)
+struct PartialPerLibraryResults
 {
-    for (const auto& child : node->children) {
-        const auto path = child.symbol.path;
+    // libraries in order of their first occurrence
+    QVector<Symbol> libraries;
+    QHash<QString, int> pathToIndex;
+    Costs costs;
+};
 
-        auto resultIndexIt = pathToResultIndex.find(path);
-        if (resultIndexIt == pathToResultIndex.end()) {
-            resultIndexIt = pathToResultIndex.insert(path, pathToResultIndex.size());
+void buildPerLibrary(const TopDown& node, PartialPerLibraryResults& results, const Costs& costs)
+{
+    const auto& path = node.symbol.path;
 
-            PerLibrary library;
-            library.id = *resultIndexIt;
-            library.symbol = Symbol({}, 0, 0, child.symbol.binary, child.symbol.path, child.symbol.actualPath,
-                                    child.symbol.isKernel);
-            results.root.children.push_back(library);
-        }
+    auto resultIndexIt = results.pathToIndex.find(path);
+    if (resultIndexIt == results.pathToIndex.end()) {
+        resultIndexIt = results.pathToIndex.insert(path, results.libraries.size());
+        results.libraries.push_back(
+            Symbol({}, 0, 0, node.symbol.binary, node.symbol.path, node.symbol.actualPath, node.symbol.isKernel));
+    }
 
-        const auto cost = costs.itemCost(child.id);
-        results.costs.add(*resultIndexIt, cost);
+    results.costs.add(*resultIndexIt, costs, node.id);
 
-        buildPerLibrary(&child, results, pathToResultIndex, costs);
+    for (const auto& child : node.children) {
+        buildPerLibrary(child, results, costs);
     }
 }
 }
@@ -289,40 +450,251 @@ QString Data::prettifySymbol(const QString& name)
     return result == name ? name : result;
 }
 
-TopDownResults TopDownResults::fromBottomUp(const BottomUpResults& bottomUpData, bool skipFirstLevel)
+const QVector<qint32>& SymbolStackIndex::stacksForSymbol(const Symbol& symbol) const
 {
-    TopDownResults results;
-    results.selfCosts.initializeCostsFrom(bottomUpData.costs);
-    results.inclusiveCosts.initializeCostsFrom(bottomUpData.costs);
-    quint32 maxId = 0;
-    if (skipFirstLevel) {
-        results.root.children.reserve(bottomUpData.root.children.size());
-        for (const auto& bottomUpGroup : bottomUpData.root.children) {
-            // manually copy the first level
-            auto topDownGroup = results.root.entryForSymbol(bottomUpGroup.symbol, &maxId);
-            // then traverse the children as separate trees basically
-            buildTopDownResult(bottomUpGroup, bottomUpData.costs, topDownGroup, &results.inclusiveCosts,
-                               &results.selfCosts, &maxId, true);
-            // finally manually sum up the inclusive costs
-            for (const auto& child : std::as_const(topDownGroup->children)) {
-                results.inclusiveCosts.add(topDownGroup->id, results.inclusiveCosts.itemCost(child.id));
+    static const QVector<qint32> noStacks;
+    const auto it = symbolIds.constFind(symbol);
+    return it == symbolIds.cend() ? noStacks : stacks[it.value()];
+}
+
+SymbolStackIndex SymbolStackIndex::fromStacks(const QVector<QVector<qint32>>& stacks,
+                                              const BottomUpResults& bottomUpData)
+{
+    SymbolStackIndex index;
+
+    // only hash every symbol once, all frames of the stacks only refer to locations
+    const auto& symbols = bottomUpData.symbols;
+    const auto& locations = bottomUpData.locations;
+    QVector<qint32> locationSymbolIds(symbols.size(), -1);
+    for (int i = 0, c = symbols.size(); i < c; ++i) {
+        const auto& symbol = symbols[i];
+        if (!symbol.isValid())
+            continue;
+        auto it = index.symbolIds.find(symbol);
+        if (it == index.symbolIds.end())
+            it = index.symbolIds.insert(symbol, index.symbolIds.size());
+        locationSymbolIds[i] = it.value();
+    }
+    index.stacks.resize(index.symbolIds.size());
+
+    auto symbolId = [&](qint32 locationId) { return locationSymbolIds.value(locationId, -1); };
+    for (int stackId = 0, numStacks = stacks.size(); stackId < numStacks; ++stackId) {
+        // this mirrors BottomUpResults::handleFrame
+        for (auto locationId : stacks[stackId]) {
+            bool skipNextFrame = false;
+            while (locationId >= 0 && locationId < locations.size()) {
+                const auto parentLocationId = locations[locationId].parentLocationId;
+                if (skipNextFrame) {
+                    locationId = parentLocationId;
+                    skipNextFrame = false;
+                    continue;
+                }
+
+                auto id = symbolId(locationId);
+                if (id == -1) {
+                    id = symbolId(parentLocationId);
+                    skipNextFrame = true;
+                }
+
+                // a symbol can occur multiple times within the same stack, e.g. for recursion
+                if (id != -1 && (index.stacks[id].isEmpty() || index.stacks[id].last() != stackId))
+                    index.stacks[id].append(stackId);
+
+                locationId = parentLocationId;
             }
         }
-    } else {
-        buildTopDownResult(bottomUpData.root, bottomUpData.costs, &results.root, &results.inclusiveCosts,
-                           &results.selfCosts, &maxId, false);
     }
+
+    return index;
+}
+
+namespace {
+quint64 trigramKey(const QChar* chars)
+{
+    return (quint64(chars[0].unicode()) << 32) | (quint64(chars[1].unicode()) << 16) | chars[2].unicode();
+}
+
+// returns the text matched by @p pattern when it has no special meaning, as produced by QRegularExpression::escape
+std::optional<QString> literalPattern(const QString& pattern)
+{
+    static const auto specialChars = QStringLiteral("^$.|?*+()[]{}");
+    QString literal;
+    literal.reserve(pattern.size());
+    for (int i = 0; i < pattern.size(); ++i) {
+        auto c = pattern[i];
+        if (c == QLatin1Char('\\')) {
+            if (++i == pattern.size())
+                return std::nullopt;
+            c = pattern[i];
+            // escape sequences like \d or \0
+            if (c.isLetterOrNumber())
+                return std::nullopt;
+        } else if (specialChars.contains(c)) {
+            return std::nullopt;
+        }
+        literal.append(c);
+    }
+    return literal;
+}
+}
+
+void TrigramIndex::build(const QVector<Symbol>& symbols)
+{
+    m_postings.clear();
+    for (qint32 id = 0, numSymbols = symbols.size(); id < numSymbols; ++id) {
+        for (const auto* text : {&symbols[id].symbol, &symbols[id].binary}) {
+            const auto folded = text->toCaseFolded();
+            for (int i = 0, end = folded.size() - 2; i < end; ++i) {
+                auto& ids = m_postings[trigramKey(folded.constData() + i)];
+                // ids are visited in order, so this keeps the lists sorted and unique
+                if (ids.isEmpty() || ids.constLast() != id)
+                    ids.append(id);
+            }
+        }
+    }
+    m_postings.squeeze();
+}
+
+std::optional<QVector<qint32>> TrigramIndex::candidates(const QString& needle) const
+{
+    if (needle.size() < 3)
+        return std::nullopt;
+
+    const auto folded = needle.toCaseFolded();
+    QVector<const QVector<qint32>*> postings;
+    postings.reserve(folded.size() - 2);
+    for (int i = 0, end = folded.size() - 2; i < end; ++i) {
+        auto it = m_postings.constFind(trigramKey(folded.constData() + i));
+        if (it == m_postings.constEnd())
+            return QVector<qint32>();
+        postings.append(&it.value());
+    }
+
+    // intersect the shortest lists first, to keep the intermediate results small
+    std::sort(postings.begin(), postings.end(),
+              [](const QVector<qint32>* lhs, const QVector<qint32>* rhs) { return lhs->size() < rhs->size(); });
+    auto ret = *postings.constFirst();
+    QVector<qint32> intersection;
+    for (auto it = std::next(postings.cbegin()), end = postings.cend(); it != end && !ret.isEmpty(); ++it) {
+        intersection.clear();
+        std::set_intersection(ret.cbegin(), ret.cend(), (*it)->cbegin(), (*it)->cend(),
+                              std::back_inserter(intersection));
+        std::swap(ret, intersection);
+    }
+    return ret;
+}
+
+qint32 SymbolTable::insert(const Symbol& symbol)
+{
+    auto it = ids.find(symbol);
+    if (it == ids.end()) {
+        it = ids.insert(symbol, symbols.size());
+        symbols.append(symbol);
+    }
+    return it.value();
+}
+
+SymbolTable SymbolTable::fromSymbols(const QVector<Symbol>& symbols)
+{
+    SymbolTable table;
+    table.ids.reserve(symbols.size());
+    for (const auto& symbol : symbols) {
+        if (symbol.isValid())
+            table.insert(symbol);
+    }
+    table.buildIndex();
+    return table;
+}
+
+SymbolMatches::SymbolMatches(SymbolTable symbolTable, QRegularExpression pattern)
+    : m_symbolTable(std::move(symbolTable))
+    , m_pattern(std::move(pattern))
+    , m_bits(m_symbolTable.symbols.size())
+{
+    if (!isActive())
+        return;
+
+    // compile the pattern once upfront, instead of racing to do that in every job
+    m_pattern.optimize();
+
+    const auto& symbols = m_symbolTable.symbols;
+
+    // for literal searches, only the symbols that contain all trigrams of the search can match
+    std::optional<QVector<qint32>> candidates;
+    if (!m_symbolTable.trigrams.isEmpty()) {
+        if (const auto literal = literalPattern(m_pattern.pattern()))
+            candidates = m_symbolTable.trigrams.candidates(*literal);
+    }
+
+    const int numCandidates = candidates ? candidates->size() : symbols.size();
+    const auto matchingIds = runChunked(numCandidates, [&](int begin, int end) {
+        QVector<qint32> ids;
+        for (int i = begin; i < end; ++i) {
+            const auto id = candidates ? candidates->at(i) : i;
+            if (matches(symbols[id], m_pattern))
+                ids.append(id);
+        }
+        return ids;
+    });
+
+    for (const auto& ids : matchingIds) {
+        for (auto id : ids)
+            m_bits.setBit(id);
+    }
+}
+
+bool SymbolMatches::matches(const Symbol& symbol, const QRegularExpression& pattern)
+{
+    return pattern.match(symbol.symbol).hasMatch() || pattern.match(symbol.binary).hasMatch()
+        || (symbol.symbol.isEmpty() && pattern.pattern() == QLatin1String("\\?\\?"));
+}
+
+TopDownResults TopDownResults::fromBottomUp(const BottomUpResults& bottomUpData, bool skipFirstLevel)
+{
+    // the top-level bottom-up nodes can be processed independently, which also nicely partitions the data
+    // when we aggregate by thread or process. the partial results then get merged afterwards
+    const auto& topLevel = bottomUpData.root.children;
+    auto partialResults = runChunked(topLevel.size(), [&](int begin, int end) {
+        return buildPartialTopDownResult(topLevel.cbegin() + begin, topLevel.cbegin() + end, bottomUpData,
+                                         skipFirstLevel);
+    });
+
+    auto results = mergeTopDownResults(std::move(partialResults));
     TopDown::initializeParents(&results.root);
     return results;
 }
 
 PerLibraryResults PerLibraryResults::fromTopDown(const TopDownResults& topDownData)
 {
+    const auto& topLevel = topDownData.root.children;
+    const auto partialResults = runChunked(topLevel.size(), [&](int begin, int end) {
+        PartialPerLibraryResults results;
+        results.costs.initializeCostsFrom(topDownData.selfCosts);
+        for (auto it = topLevel.cbegin() + begin, itEnd = topLevel.cbegin() + end; it != itEnd; ++it) {
+            buildPerLibrary(*it, results, topDownData.selfCosts);
+        }
+        return results;
+    });
+
     PerLibraryResults results;
-    QHash<QString, int> pathToResultIndex;
     results.costs.initializeCostsFrom(topDownData.selfCosts);
+    QHash<QString, int> pathToResultIndex;
 
-    buildPerLibrary(&topDownData.root, results, pathToResultIndex, topDownData.selfCosts);
+    for (const auto& partialResult : partialResults) {
+        for (int i = 0, c = partialResult.libraries.size(); i < c; ++i) {
+            const auto& library = partialResult.libraries[i];
+            auto resultIndexIt = pathToResultIndex.find(library.path);
+            if (resultIndexIt == pathToResultIndex.end()) {
+                resultIndexIt = pathToResultIndex.insert(library.path, pathToResultIndex.size());
+
+                PerLibrary perLibrary;
+                perLibrary.id = *resultIndexIt;
+                perLibrary.symbol = library;
+                results.root.children.push_back(perLibrary);
+            }
+            results.costs.add(*resultIndexIt, partialResult.costs, i);
+        }
+    }
 
     PerLibrary::initializeParents(&results.root);
 
@@ -334,6 +706,108 @@ void Data::callerCalleesFromBottomUpData(const BottomUpResults& bottomUpData, Ca
     results->inclusiveCosts.initializeCostsFrom(bottomUpData.costs);
     results->selfCosts.initializeCostsFrom(bottomUpData.costs);
     buildCallerCalleeResult(bottomUpData.root, bottomUpData.costs, results);
+
+    // all samples got added to the per-address costs at this point
+    for (auto& binaryOffsetCosts : results->binaryOffsetMap) {
+        binaryOffsetCosts.finalize();
+    }
+}
+
+void Data::BinaryOffsetCosts::finalize()
+{
+    if (m_pending.isEmpty()) {
+        return;
+    }
+
+    QVector<quint64> pendingAddresses;
+    pendingAddresses.reserve(m_pending.size());
+    for (auto it = m_pending.keyBegin(), end = m_pending.keyEnd(); it != end; ++it) {
+        pendingAddresses.append(*it);
+    }
+    std::sort(pendingAddresses.begin(), pendingAddresses.end());
+
+    // the pending addresses are never part of the sorted ones, so we can simply merge both
+    QVector<quint64> addresses;
+    QVector<LocationCost> costs;
+    addresses.reserve(m_addresses.size() + pendingAddresses.size());
+    costs.reserve(addresses.capacity());
+
+    qsizetype sortedIndex = 0;
+    for (const auto addr : std::as_const(pendingAddresses)) {
+        for (; sortedIndex < m_addresses.size() && m_addresses[sortedIndex] < addr; ++sortedIndex) {
+            addresses.append(m_addresses[sortedIndex]);
+            costs.append(std::move(m_costs[sortedIndex]));
+        }
+        addresses.append(addr);
+        costs.append(m_pending.take(addr));
+    }
+    for (; sortedIndex < m_addresses.size(); ++sortedIndex) {
+        addresses.append(m_addresses[sortedIndex]);
+        costs.append(std::move(m_costs[sortedIndex]));
+    }
+
+    m_addresses = std::move(addresses);
+    m_costs = std::move(costs);
+    m_pending.clear();
+}
+
+QVector<quint64> Data::BinaryOffsetCosts::hottestAddresses(int type, int numAddresses) const
+{
+    QVector<std::pair<qint64, quint64>> costs;
+    costs.reserve(size());
+    for (qsizetype i = 0, c = m_addresses.size(); i < c; ++i) {
+        costs.append({m_costs[i].selfCost[type], m_addresses[i]});
+    }
+    for (auto it = m_pending.cbegin(), end = m_pending.cend(); it != end; ++it) {
+        costs.append({it->selfCost[type], it.key()});
+    }
+
+    const auto numHottest = std::min<qsizetype>(numAddresses, costs.size());
+    std::partial_sort(costs.begin(), costs.begin() + numHottest, costs.end(),
+                      [](const std::pair<qint64, quint64>& lhs, const std::pair<qint64, quint64>& rhs) {
+                          // prefer lower addresses for equal costs to get stable results
+                          return std::tie(rhs.first, lhs.second) < std::tie(lhs.first, rhs.second);
+                      });
+
+    QVector<quint64> addresses;
+    addresses.reserve(numHottest);
+    for (qsizetype i = 0; i < numHottest; ++i) {
+        addresses.append(costs[i].second);
+    }
+    return addresses;
+}
+
+QVector<Data::FrequencyData> Data::windowedFrequencies(const Events& events, qint32 type, quint64 windowSize)
+{
+    QVector<FrequencyData> frequencies;
+    if (!windowSize) {
+        return frequencies;
+    }
+
+    quint64 window = 0;
+    quint64 cost = 0;
+    bool hasEvents = false;
+    auto addWindow = [&]() {
+        frequencies.append({window * windowSize + windowSize / 2, static_cast<double>(cost) / windowSize});
+    };
+
+    for (const auto& event : events) {
+        if (event.type != type) {
+            continue;
+        }
+        const auto eventWindow = event.time / windowSize;
+        if (hasEvents && eventWindow != window) {
+            addWindow();
+            cost = 0;
+        }
+        window = eventWindow;
+        cost += event.cost;
+        hasEvents = true;
+    }
+    if (hasEvents) {
+        addWindow();
+    }
+    return frequencies;
 }
 
 QDebug Data::operator<<(QDebug stream, const Symbol& symbol)
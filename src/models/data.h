@@ -7,8 +7,10 @@
 
 #pragma once
 
+#include <QBitArray>
 #include <QHash>
 #include <QMetaType>
+#include <QRegularExpression>
 #include <QSet>
 #include <QString>
 #include <QTypeInfo>
@@ -16,7 +18,10 @@
 
 #include "../util.h"
 
+#include <algorithm>
+#include <iterator>
 #include <limits>
+#include <optional>
 #include <tuple>
 #include <utility>
 #include <valarray>
@@ -381,6 +386,18 @@ public:
         }
     }
 
+    // adds the costs of item @p rhsId in @p rhs to item @p id, without allocating an intermediate ItemCost
+    void add(quint32 id, const Costs& rhs, quint32 rhsId)
+    {
+        Q_ASSERT(rhs.numTypes() == numTypes());
+        for (int i = 0, c = numTypes(); i < c; ++i) {
+            const auto cost = rhs.cost(i, rhsId);
+            if (cost) {
+                add(i, id, cost);
+            }
+        }
+    }
+
     void initializeCostsFrom(const Costs& rhs)
     {
         m_typeNames = rhs.m_typeNames;
@@ -621,22 +638,6 @@ struct FrequencyData
     double cost = 0;
 };
 
-struct PerCostFrequencyData
-{
-    QString costName;
-    QVector<FrequencyData> values;
-};
-
-struct PerCoreFrequencyData
-{
-    QVector<PerCostFrequencyData> costs;
-};
-
-struct FrequencyResults
-{
-    QVector<PerCoreFrequencyData> cores;
-};
-
 using SymbolCostMap = QHash<Symbol, ItemCost>;
 using CalleeMap = SymbolCostMap;
 using CallerMap = SymbolCostMap;
@@ -654,7 +655,69 @@ struct LocationCost
 };
 
 using SourceLocationCostMap = QHash<FileLine, LocationCost>;
-using OffsetLocationCostMap = QHash<quint64, LocationCost>;
+
+// the costs of the sampled addresses (relAddr) of one binary
+// costs get accumulated in a hash first, finalize() then moves them into arrays that are sorted by address
+// this keeps the lookups for all instructions of a symbol cheap and allows to query the hottest addresses
+class BinaryOffsetCosts
+{
+public:
+    LocationCost& cost(quint64 addr, int numTypes)
+    {
+        const auto index = sortedIndex(addr);
+        auto* locationCost = index == -1 ? nullptr : &m_costs[index];
+        if (!locationCost) {
+            auto it = m_pending.find(addr);
+            if (it == m_pending.end()) {
+                it = m_pending.insert(addr, {numTypes});
+            }
+            locationCost = &(*it);
+        }
+        if (locationCost->inclusiveCost.size() < static_cast<size_t>(numTypes)) {
+            locationCost->inclusiveCost.resize(numTypes);
+            locationCost->selfCost.resize(numTypes);
+        }
+        return *locationCost;
+    }
+
+    const LocationCost* find(quint64 addr) const
+    {
+        const auto index = sortedIndex(addr);
+        if (index != -1) {
+            return &m_costs.at(index);
+        }
+        if (m_pending.isEmpty()) {
+            return nullptr;
+        }
+        auto it = m_pending.constFind(addr);
+        return it == m_pending.constEnd() ? nullptr : &(*it);
+    }
+
+    // moves the accumulated costs into the sorted arrays
+    void finalize();
+
+    // the sampled addresses sorted by descending self cost of @p type, at most @p numAddresses of them
+    QVector<quint64> hottestAddresses(int type, int numAddresses) const;
+
+    qsizetype size() const
+    {
+        return m_addresses.size() + m_pending.size();
+    }
+
+private:
+    qsizetype sortedIndex(quint64 addr) const
+    {
+        auto it = std::lower_bound(m_addresses.cbegin(), m_addresses.cend(), addr);
+        if (it == m_addresses.cend() || *it != addr) {
+            return -1;
+        }
+        return std::distance(m_addresses.cbegin(), it);
+    }
+
+    QVector<quint64> m_addresses;
+    QVector<LocationCost> m_costs;
+    QHash<quint64, LocationCost> m_pending;
+};
 
 inline LocationCost& source(SourceLocationCostMap& sourceMap, const FileLine& fileLine, int numTypes)
 {
@@ -707,8 +770,8 @@ using CallerCalleeEntryMap = QHash<Symbol, CallerCalleeEntry>;
 struct CallerCalleeResults
 {
     CallerCalleeEntryMap entries;
-    // per-binary map of per-IP (relAddr) map for disassembly
-    QHash<QString, OffsetLocationCostMap> binaryOffsetMap;
+    // per-binary costs per IP (relAddr) for disassembly
+    QHash<QString, BinaryOffsetCosts> binaryOffsetMap;
     Costs selfCosts;
     Costs inclusiveCosts;
 
@@ -728,15 +791,13 @@ struct CallerCalleeResults
         if (binaryIt == binaryOffsetMap.end()) {
             binaryIt = binaryOffsetMap.insert(binary, {});
         }
+        return binaryIt->cost(addr, numTypes);
+    }
 
-        auto it = binaryIt->find(addr);
-        if (it == binaryIt->end()) {
-            it = binaryIt->insert(addr, {numTypes});
-        } else if (it->inclusiveCost.size() < static_cast<size_t>(numTypes)) {
-            it->inclusiveCost.resize(numTypes);
-            it->selfCost.resize(numTypes);
-        }
-        return *it;
+    const BinaryOffsetCosts* binaryOffsetCosts(const QString& binary) const
+    {
+        auto it = binaryOffsetMap.constFind(binary);
+        return it == binaryOffsetMap.constEnd() ? nullptr : &(*it);
     }
 };
 
@@ -793,6 +854,23 @@ struct Event
 
 using Events = QVector<Event>;
 
+// returns the items of @p items for which @p keep returns true
+// when everything is kept, the original implicitly shared container is returned, i.e. no copy is made
+// otherwise only the selected items get copied into a new container
+template<typename Container, typename Predicate>
+Container selectItems(const Container& items, Predicate keep)
+{
+    auto firstDropped = std::find_if_not(items.cbegin(), items.cend(), keep);
+    if (firstDropped == items.cend()) {
+        return items;
+    }
+
+    Container selected;
+    std::copy(items.cbegin(), firstDropped, std::back_inserter(selected));
+    std::copy_if(std::next(firstDropped), items.cend(), std::back_inserter(selected), keep);
+    return selected;
+}
+
 struct TimeRange
 {
     constexpr TimeRange() = default;
@@ -846,6 +924,46 @@ struct TimeRange
 const constexpr auto MAX_TIME = std::numeric_limits<quint64>::max();
 const constexpr auto MAX_TIME_RANGE = TimeRange {0, MAX_TIME};
 
+// all containers with a `time` member, i.e. events, tracepoints and frequency data, are kept sorted by time
+// this allows us to clip them to a time range with two binary searches instead of a full scan
+template<typename Container>
+void sortByTime(Container* items)
+{
+    using Item = typename Container::value_type;
+    auto byTime = [](const Item& lhs, const Item& rhs) { return lhs.time < rhs.time; };
+    if (!std::is_sorted(items->cbegin(), items->cend(), byTime)) {
+        std::stable_sort(items->begin(), items->end(), byTime);
+    }
+}
+
+// returns the range of items in the time-sorted @p items that lie within @p time
+template<typename Container>
+auto findTimeRange(const Container& items, TimeRange time)
+{
+    using Item = typename Container::value_type;
+    auto begin = std::lower_bound(items.cbegin(), items.cend(), time.start,
+                                  [](const Item& item, quint64 time) { return item.time < time; });
+    auto end = std::upper_bound(begin, items.cend(), time.end,
+                                [](quint64 time, const Item& item) { return time < item.time; });
+    return std::make_pair(begin, end);
+}
+
+// returns the items in the time-sorted @p items that lie within @p time
+// when everything lies within the range, the original implicitly shared container is returned
+template<typename Container>
+Container clipToTimeRange(const Container& items, TimeRange time)
+{
+    const auto range = findTimeRange(items, time);
+    if (range.first == items.cbegin() && range.second == items.cend()) {
+        return items;
+    }
+    return Container(range.first, range.second);
+}
+
+// sums up the cost of the events of @p type in the time-sorted @p events over windows of @p windowSize nanoseconds
+// returns the cost per nanosecond for every window that has such an event, placed at the center of the window
+QVector<FrequencyData> windowedFrequencies(const Events& events, qint32 type, quint64 windowSize);
+
 struct ThreadEvents
 {
     qint32 pid = INVALID_PID;
@@ -855,6 +973,8 @@ struct ThreadEvents
     QString name;
     quint64 lastSwitchTime = MAX_TIME;
     quint64 offCpuTime = 0;
+    // stack of the last sched:sched_switch sample, used to attribute the off-CPU time when we get switched in again
+    qint32 lastSchedSwitchStackId = -1;
     enum State
     {
         Unknown,
@@ -865,9 +985,9 @@ struct ThreadEvents
 
     bool operator==(const ThreadEvents& rhs) const
     {
-        return std::tie(pid, tid, time, events, name, lastSwitchTime, offCpuTime, state)
+        return std::tie(pid, tid, time, events, name, lastSwitchTime, offCpuTime, lastSchedSwitchStackId, state)
             == std::tie(rhs.pid, rhs.tid, rhs.time, rhs.events, rhs.name, rhs.lastSwitchTime, rhs.offCpuTime,
-                        rhs.state);
+                        rhs.lastSchedSwitchStackId, rhs.state);
     }
 };
 
@@ -960,6 +1080,108 @@ struct EventResults
     }
 };
 
+// maps every symbol to the stacks it occurs in, to quickly find the events that belong to a symbol
+struct SymbolStackIndex
+{
+    QHash<Symbol, qint32> symbolIds;
+    // ascending stack ids for every symbol id
+    QVector<QVector<qint32>> stacks;
+
+    const QVector<qint32>& stacksForSymbol(const Symbol& symbol) const;
+
+    static SymbolStackIndex fromStacks(const QVector<QVector<qint32>>& stacks, const BottomUpResults& bottomUpData);
+};
+
+// maps every trigram of the symbol names and binaries to the ids of the symbols that contain it
+class TrigramIndex
+{
+public:
+    void build(const QVector<Symbol>& symbols);
+
+    bool isEmpty() const
+    {
+        return m_postings.isEmpty();
+    }
+
+    // returns the sorted ids of all symbols that may contain @p needle, ignoring the case
+    // returns std::nullopt when the needle is too short to be looked up
+    std::optional<QVector<qint32>> candidates(const QString& needle) const;
+
+private:
+    QHash<quint64, QVector<qint32>> m_postings;
+};
+
+// the unique symbols of a result, to evaluate searches once per symbol instead of once per frame or row
+struct SymbolTable
+{
+    QVector<Symbol> symbols;
+    QHash<Symbol, qint32> ids;
+    // optional, lets literal searches skip the symbols that cannot match
+    TrigramIndex trigrams;
+
+    // returns -1 for symbols that are not part of the table
+    qint32 id(const Symbol& symbol) const
+    {
+        return ids.value(symbol, -1);
+    }
+
+    // returns the id of @p symbol, adding it to the table if needed
+    qint32 insert(const Symbol& symbol);
+
+    void buildIndex()
+    {
+        trigrams.build(symbols);
+    }
+
+    // also builds the trigram index
+    static SymbolTable fromSymbols(const QVector<Symbol>& symbols);
+};
+
+// the result of a search over all symbols of a symbol table
+class SymbolMatches
+{
+public:
+    SymbolMatches() = default;
+    // matches the symbols in parallel, don't call this on the GUI thread
+    SymbolMatches(SymbolTable symbolTable, QRegularExpression pattern);
+
+    // no search is active when the pattern is empty, then nothing gets filtered
+    bool isActive() const
+    {
+        return !m_pattern.pattern().isEmpty();
+    }
+
+    const QRegularExpression& pattern() const
+    {
+        return m_pattern;
+    }
+
+    // one bit per symbol id, set for the matching symbols
+    const QBitArray& bits() const
+    {
+        return m_bits;
+    }
+
+    bool matches(qint32 symbolId) const
+    {
+        return m_bits.testBit(symbolId);
+    }
+
+    // symbols that are not part of the table get matched directly
+    bool matches(const Symbol& symbol) const
+    {
+        const auto id = m_symbolTable.id(symbol);
+        return id == -1 ? matches(symbol, m_pattern) : matches(id);
+    }
+
+    static bool matches(const Symbol& symbol, const QRegularExpression& pattern);
+
+private:
+    SymbolTable m_symbolTable;
+    QRegularExpression m_pattern;
+    QBitArray m_bits;
+};
+
 struct Tracepoint
 {
     quint64 time = 0;
@@ -1023,7 +1245,6 @@ Q_DECLARE_TYPEINFO(Data::BottomUp, Q_MOVABLE_TYPE);
 Q_DECLARE_METATYPE(Data::ItemCost)
 Q_DECLARE_METATYPE(Data::CallerMap)
 Q_DECLARE_METATYPE(Data::SourceLocationCostMap)
-Q_DECLARE_METATYPE(Data::OffsetLocationCostMap)
 Q_DECLARE_METATYPE(Data::Costs)
 
 Q_DECLARE_METATYPE(Data::TopDown)
@@ -1056,15 +1277,6 @@ Q_DECLARE_TYPEINFO(Data::Event, Q_MOVABLE_TYPE);
 Q_DECLARE_METATYPE(Data::FrequencyData)
 Q_DECLARE_TYPEINFO(Data::FrequencyData, Q_MOVABLE_TYPE);
 
-Q_DECLARE_METATYPE(Data::PerCostFrequencyData)
-Q_DECLARE_TYPEINFO(Data::PerCostFrequencyData, Q_MOVABLE_TYPE);
-
-Q_DECLARE_METATYPE(Data::PerCoreFrequencyData)
-Q_DECLARE_TYPEINFO(Data::PerCoreFrequencyData, Q_MOVABLE_TYPE);
-
-Q_DECLARE_METATYPE(Data::FrequencyResults)
-Q_DECLARE_TYPEINFO(Data::FrequencyResults, Q_MOVABLE_TYPE);
-
 Q_DECLARE_METATYPE(Data::ThreadEvents)
 Q_DECLARE_TYPEINFO(Data::ThreadEvents, Q_MOVABLE_TYPE);
 
@@ -1092,5 +1304,8 @@ Q_DECLARE_TYPEINFO(Data::TracepointResults, Q_MOVABLE_TYPE);
 Q_DECLARE_METATYPE(Data::TimeRange)
 Q_DECLARE_TYPEINFO(Data::TimeRange, Q_MOVABLE_TYPE);
 
+Q_DECLARE_METATYPE(Data::SymbolTable)
+Q_DECLARE_TYPEINFO(Data::SymbolTable, Q_MOVABLE_TYPE);
+
 Q_DECLARE_TYPEINFO(Data::FilterAction, Q_MOVABLE_TYPE);
 Q_DECLARE_TYPEINFO(Data::ZoomAction, Q_MOVABLE_TYPE);
@@ -0,0 +1,268 @@
+/*
+    SPDX-FileCopyrightText: Milian Wolff <milian.wolff@kdab.com>
+    SPDX-FileCopyrightText: 2016 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "disassemblycache.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QLoggingCategory>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+namespace {
+Q_LOGGING_CATEGORY(disassemblycache, "hotspot.disassemblycache")
+
+// bump this whenever the serialized format or the parsing of the objdump output changes
+constexpr quint32 diskCacheMagic = 0x48534443; // HSDC
+constexpr quint32 diskCacheVersion = 2;
+// pinned, so that entries stay readable across Qt versions
+constexpr auto diskCacheStreamVersion = QDataStream::Qt_6_4;
+constexpr qint64 maxDiskCacheSize = 128 * 1024 * 1024;
+// prune a bit more than necessary, to not scan the directory again after the next few inserts
+constexpr qint64 prunedDiskCacheSize = maxDiskCacheSize / 4 * 3;
+
+QString keyString(const DisassemblyCache::Key& key)
+{
+    return key.binary + QLatin1Char('\n') + key.binaryVersion + QLatin1Char('\n') + QString::number(key.start, 16)
+        + QLatin1Char('-') + QString::number(key.end, 16) + QLatin1Char('\n') + key.objdumpFlags.join(QLatin1Char(' '));
+}
+}
+
+QByteArray DisassemblyCache::Key::hash() const
+{
+    return QCryptographicHash::hash(keyString(*this).toUtf8(), QCryptographicHash::Sha1).toHex();
+}
+
+DisassemblyCache::Key DisassemblyCache::key(const QString& binary, quint64 start, quint64 end,
+                                            const QStringList& objdumpFlags)
+{
+    const auto info = QFileInfo(binary);
+    if (!info.exists()) {
+        return {};
+    }
+
+    const auto version = QString::number(info.lastModified().toMSecsSinceEpoch()) + QLatin1Char(':')
+        + QString::number(info.size());
+    return {info.absoluteFilePath(), version, start, end, objdumpFlags};
+}
+
+DisassemblyCache::DisassemblyCache(int maxCost)
+    : m_cache(maxCost)
+{
+}
+
+DisassemblyCache* DisassemblyCache::instance()
+{
+    static DisassemblyCache cache;
+    return &cache;
+}
+
+std::optional<DisassemblyOutput::ObjectdumpOutput> DisassemblyCache::find(const Key& key)
+{
+    if (!key.isValid()) {
+        return {};
+    }
+
+    const auto hash = key.hash();
+    QString diskCacheDirectory;
+    {
+        QMutexLocker lock(&m_mutex);
+        if (auto* output = m_cache.object(hash)) {
+            return *output;
+        }
+        diskCacheDirectory = m_diskCacheDirectory;
+    }
+
+    if (diskCacheDirectory.isEmpty()) {
+        return {};
+    }
+
+    // don't block other lookups while we read from disk
+    auto output = readFromDisk(diskCacheDirectory, key, hash);
+    if (output) {
+        QMutexLocker lock(&m_mutex);
+        m_cache.insert(hash, new DisassemblyOutput::ObjectdumpOutput(*output),
+                       std::max<qsizetype>(1, output->disassemblyLines.size()));
+    }
+    return output;
+}
+
+void DisassemblyCache::insert(const Key& key, const DisassemblyOutput::ObjectdumpOutput& output)
+{
+    if (!key.isValid()) {
+        return;
+    }
+
+    const auto hash = key.hash();
+    QString diskCacheDirectory;
+    {
+        QMutexLocker lock(&m_mutex);
+        m_cache.insert(hash, new DisassemblyOutput::ObjectdumpOutput(output),
+                       std::max<qsizetype>(1, output.disassemblyLines.size()));
+        diskCacheDirectory = m_diskCacheDirectory;
+    }
+
+    if (diskCacheDirectory.isEmpty()) {
+        return;
+    }
+
+    const auto size = writeToDisk(diskCacheDirectory, key, hash, output);
+    if (m_diskCacheSize.fetch_add(size) + size > maxDiskCacheSize) {
+        pruneDiskCache(diskCacheDirectory);
+    }
+}
+
+void DisassemblyCache::clear()
+{
+    QMutexLocker lock(&m_mutex);
+    m_cache.clear();
+}
+
+void DisassemblyCache::setDiskCacheDirectory(const QString& path)
+{
+    if (!path.isEmpty() && !QDir().mkpath(path)) {
+        qCWarning(disassemblycache) << "failed to create disassembly cache directory" << path;
+        setDiskCacheDirectory({});
+        return;
+    }
+
+    {
+        QMutexLocker lock(&m_mutex);
+        if (m_diskCacheDirectory == path) {
+            return;
+        }
+        m_diskCacheDirectory = path;
+    }
+
+    if (!path.isEmpty()) {
+        // this also initializes the size of the cache directory
+        pruneDiskCache(path);
+    }
+}
+
+QString DisassemblyCache::diskCacheDirectory() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_diskCacheDirectory;
+}
+
+QString DisassemblyCache::defaultDiskCacheDirectory()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QLatin1String("/disassembly");
+}
+
+std::optional<DisassemblyOutput::ObjectdumpOutput>
+DisassemblyCache::readFromDisk(const QString& directory, const Key& key, const QByteArray& hash)
+{
+    QFile file(directory + QLatin1Char('/') + QString::fromLatin1(hash));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return {};
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(diskCacheStreamVersion);
+    quint32 magic = 0;
+    quint32 version = 0;
+    QString storedKey;
+    stream >> magic >> version;
+    if (magic != diskCacheMagic || version != diskCacheVersion) {
+        return {};
+    }
+    // guard against hash collisions
+    stream >> storedKey;
+    if (storedKey != keyString(key)) {
+        return {};
+    }
+
+    DisassemblyOutput::ObjectdumpOutput output;
+    qint32 numLines = 0;
+    stream >> output.mainSourceFileName >> numLines;
+    if (numLines < 0) {
+        return {};
+    }
+    output.disassemblyLines.reserve(numLines);
+    for (qint32 i = 0; i < numLines && stream.status() == QDataStream::Ok; ++i) {
+        DisassemblyOutput::DisassemblyLine line;
+        qint32 linkedOffset = 0;
+        qint32 sourceLine = 0;
+        stream >> line.addr >> line.disassembly >> line.branchVisualisation >> line.hexdump >> line.linkedFunction.name
+            >> linkedOffset >> line.fileLine.file >> sourceLine;
+        line.linkedFunction.offset = linkedOffset;
+        line.fileLine.line = sourceLine;
+        output.disassemblyLines.push_back(std::move(line));
+    }
+
+    if (stream.status() != QDataStream::Ok) {
+        qCWarning(disassemblycache) << "ignoring corrupt disassembly cache entry" << file.fileName();
+        return {};
+    }
+
+    // keep recently used entries alive when pruning
+    file.close();
+    file.open(QIODevice::ReadWrite);
+    file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+    return output;
+}
+
+qint64 DisassemblyCache::writeToDisk(const QString& directory, const Key& key, const QByteArray& hash,
+                                     const DisassemblyOutput::ObjectdumpOutput& output)
+{
+    QSaveFile file(directory + QLatin1Char('/') + QString::fromLatin1(hash));
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(disassemblycache) << "failed to write disassembly cache entry" << file.fileName()
+                                    << file.errorString();
+        return 0;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(diskCacheStreamVersion);
+    stream << diskCacheMagic << diskCacheVersion << keyString(key) << output.mainSourceFileName
+           << static_cast<qint32>(output.disassemblyLines.size());
+    for (const auto& line : output.disassemblyLines) {
+        stream << line.addr << line.disassembly << line.branchVisualisation << line.hexdump << line.linkedFunction.name
+               << static_cast<qint32>(line.linkedFunction.offset) << line.fileLine.file
+               << static_cast<qint32>(line.fileLine.line);
+    }
+
+    const auto size = file.size();
+    if (!file.commit()) {
+        qCWarning(disassemblycache) << "failed to write disassembly cache entry" << file.fileName()
+                                    << file.errorString();
+        return 0;
+    }
+    return size;
+}
+
+void DisassemblyCache::pruneDiskCache(const QString& directory)
+{
+    // only one thread needs to scan the directory
+    QMutexLocker lock(&m_pruneMutex);
+
+    // remove the least recently used entries until the cache fits again
+    const auto entries =
+        QDir(directory).entryInfoList(QDir::Files | QDir::NoDotAndDotDot, QDir::Time | QDir::Reversed);
+    qint64 totalSize = 0;
+    for (const auto& entry : entries) {
+        totalSize += entry.size();
+    }
+
+    if (totalSize > maxDiskCacheSize) {
+        for (const auto& entry : entries) {
+            if (totalSize <= prunedDiskCacheSize) {
+                break;
+            }
+            if (QFile::remove(entry.absoluteFilePath())) {
+                totalSize -= entry.size();
+            }
+        }
+    }
+    m_diskCacheSize = totalSize;
+}
@@ -0,0 +1,76 @@
+/*
+    SPDX-FileCopyrightText: Milian Wolff <milian.wolff@kdab.com>
+    SPDX-FileCopyrightText: 2016 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QByteArray>
+#include <QCache>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+
+#include "disassemblyoutput.h"
+
+#include <atomic>
+#include <optional>
+
+// caches the parsed objdump output, so that revisiting a symbol doesn't require running objdump again
+// entries are kept in memory and, when a directory is set, also on disk to reuse them across sessions
+class DisassemblyCache
+{
+public:
+    struct Key
+    {
+        QString binary;
+        // the modification time and size of the binary, a rebuild invalidates all of its entries
+        QString binaryVersion;
+        quint64 start = 0;
+        quint64 end = 0;
+        // the objdump binary and all arguments except for the address range and binary
+        QStringList objdumpFlags;
+
+        bool isValid() const
+        {
+            return !binaryVersion.isEmpty();
+        }
+
+        QByteArray hash() const;
+    };
+    static Key key(const QString& binary, quint64 start, quint64 end, const QStringList& objdumpFlags);
+
+    // the cost of an entry is its number of lines
+    explicit DisassemblyCache(int maxCost = 100000);
+
+    static DisassemblyCache* instance();
+
+    std::optional<DisassemblyOutput::ObjectdumpOutput> find(const Key& key);
+    void insert(const Key& key, const DisassemblyOutput::ObjectdumpOutput& output);
+    void clear();
+
+    // pass an empty path to disable the on-disk cache
+    void setDiskCacheDirectory(const QString& path);
+    QString diskCacheDirectory() const;
+
+    // default location for the on-disk cache
+    static QString defaultDiskCacheDirectory();
+
+private:
+    // the disk accesses happen without holding m_mutex, so that they don't block lookups in memory
+    static std::optional<DisassemblyOutput::ObjectdumpOutput> readFromDisk(const QString& directory, const Key& key,
+                                                                           const QByteArray& hash);
+    // returns the size of the written file
+    static qint64 writeToDisk(const QString& directory, const Key& key, const QByteArray& hash,
+                              const DisassemblyOutput::ObjectdumpOutput& output);
+    void pruneDiskCache(const QString& directory);
+
+    mutable QMutex m_mutex;
+    QCache<QByteArray, DisassemblyOutput::ObjectdumpOutput> m_cache;
+    QString m_diskCacheDirectory;
+    QMutex m_pruneMutex;
+    // approximate size of the disk cache, updated by every write and set exactly when pruning
+    std::atomic<qint64> m_diskCacheSize = 0;
+};
@@ -23,7 +23,7 @@ void DisassemblyModel::clear()
 {
     beginResetModel();
     m_data = {};
-    m_offsetMap = {};
+    m_rowCosts = {};
     endResetModel();
 }
 
@@ -48,9 +48,18 @@ void DisassemblyModel::setDisassembly(const DisassemblyOutput& disassemblyOutput
 
     m_data = disassemblyOutput;
     m_results = results;
-    m_offsetMap = m_results.binaryOffsetMap[m_data.symbol.binary];
     m_numTypes = results.selfCosts.numTypes();
 
+    // look up the costs once instead of for every data() call
+    m_rowCosts.fill(nullptr, m_data.disassemblyLines.size());
+    if (const auto* offsetCosts = m_results.binaryOffsetCosts(m_data.symbol.binary)) {
+        for (int i = 0, c = m_data.disassemblyLines.size(); i < c; ++i) {
+            if (const auto addr = m_data.disassemblyLines[i].addr) {
+                m_rowCosts[i] = offsetCosts->find(addr);
+            }
+        }
+    }
+
     QStringList assemblyLines;
     assemblyLines.reserve(disassemblyOutput.disassemblyLines.size());
     std::transform(disassemblyOutput.disassemblyLines.cbegin(), disassemblyOutput.disassemblyLines.cend(),
@@ -133,10 +142,9 @@ QVariant DisassemblyModel::data(const QModelIndex& index, int role) const
         const auto tooltip = tr("addr: <tt>%1</tt><br/>assembly: <tt>%2</tt><br/>hexdump: <tt>%3</tt>")
                                  .arg(QString::number(data.addr, 16), line.toHtmlEscaped(), data.hexdump);
 
-        auto it = m_offsetMap.find(data.addr);
-        if (it != m_offsetMap.end()) {
+        if (const auto* rowCost = m_rowCosts.value(index.row())) {
             const auto event = index.column() - COLUMN_COUNT;
-            const auto& locationCost = it.value();
+            const auto& locationCost = *rowCost;
 
             if (role == Qt::ToolTipRole) {
                 return Util::formatTooltip(tooltip, locationCost, m_results.selfCosts);
@@ -227,9 +235,8 @@ QModelIndex DisassemblyModel::indexForFileLine(const Data::FileLine& fileLine) c
             bestMatch = i;
         }
 
-        auto it = m_offsetMap.find(line.addr);
-        if (it != m_offsetMap.end()) {
-            const auto& locationCost = it.value();
+        if (const auto* rowCost = m_rowCosts.value(i)) {
+            const auto& locationCost = *rowCost;
 
             if (!bestCost || bestCost < locationCost.selfCost[0]) {
                 bestMatch = i;
@@ -83,7 +83,8 @@ private:
     HighlightedText m_highlightedText;
     DisassemblyOutput m_data;
     Data::CallerCalleeResults m_results;
-    Data::OffsetLocationCostMap m_offsetMap;
+    // the costs of each row, pointing into m_results
+    QVector<const Data::LocationCost*> m_rowCosts;
     int m_numTypes = 0;
     int m_highlightLine = 0;
 };
@@ -8,12 +8,18 @@
 
 #include "disassemblyoutput.h"
 #include "data.h"
+#include "disassemblycache.h"
+#include "sourcefilecache.h"
 
 #include <QApplication>
+#include <QDateTime>
 #include <QDir>
 #include <QDirIterator>
+#include <QElapsedTimer>
 #include <QFileInfo>
+#include <QHash>
 #include <QLoggingCategory>
+#include <QMutex>
 #include <QProcess>
 #include <QStandardPaths>
 
@@ -34,22 +40,69 @@ QByteArray objdumpHelp(const QString& objdump)
     return process.readAllStandardOutput();
 }
 
-bool canVisualizeJumps(const QString& objdump)
+struct ObjdumpCapabilities
 {
-    return objdumpHelp(objdump).contains("--visualize-jumps");
+    QDateTime lastModified;
+    // only available for objdump 2.34+
+    bool canVisualizeJumps = false;
+    bool canUseSyntaxHighlighting = false;
+};
+
+// probing requires running objdump, so only do that once per binary instead of for every disassembly
+ObjdumpCapabilities objdumpCapabilities(const QString& objdump)
+{
+    static QMutex mutex;
+    static QHash<QString, ObjdumpCapabilities> cache;
+
+    const auto lastModified = QFileInfo(objdump).lastModified();
+    QMutexLocker lock(&mutex);
+    auto it = cache.constFind(objdump);
+    if (it != cache.constEnd() && it->lastModified == lastModified) {
+        return *it;
+    }
+
+    const auto help = objdumpHelp(objdump);
+    const auto capabilities =
+        ObjdumpCapabilities {lastModified, help.contains("--visualize-jumps"), help.contains("--disassembler-color")};
+    // try again next time when the probe failed
+    if (!help.isEmpty()) {
+        cache.insert(objdump, capabilities);
+    }
+    return capabilities;
 }
 
-bool canUseSyntaxHighlighting(const QString& objdump)
+// the arguments passed to objdump besides the address range and binary, prefixed by objdump itself
+QStringList objdumpFlags(const QString& processPath)
 {
-    return objdumpHelp(objdump).contains("--disassembler-color");
+    auto flags = QStringList {processPath,
+                              QStringLiteral("-d"), // disassemble
+                              QStringLiteral("-l"), // include source code lines
+                              QStringLiteral("-C")}; // demangle names
+
+    const auto capabilities = objdumpCapabilities(processPath);
+    if (capabilities.canVisualizeJumps)
+        flags.append(QStringLiteral("--visualize-jumps"));
+    else
+        qCInfo(disassemblyoutput) << "objdump binary does not support `--visualize-jumps`:" << processPath;
+
+    if (capabilities.canUseSyntaxHighlighting) {
+        flags.append(QStringLiteral("--disassembler-color=color"));
+    } else {
+        qCInfo(disassemblyoutput) << "objdump binary does not support `--disassembler-color`:" << processPath;
+    }
+    return flags;
 }
 
-DisassemblyOutput::LinkedFunction extractLinkedFunction(const QString& disassemblyWithAnsi)
+DisassemblyOutput::LinkedFunction extractLinkedFunction(QStringView disassemblyWithAnsi)
 {
     DisassemblyOutput::LinkedFunction function = {};
 
-    const auto disassembly =
-        disassemblyWithAnsi.contains(Util::escapeChar) ? Util::removeAnsi(disassemblyWithAnsi) : disassemblyWithAnsi;
+    // most lines don't reference a function, don't bother removing the ANSI sequences for them
+    if (!disassemblyWithAnsi.contains(QLatin1Char('<'))) {
+        return function;
+    }
+
+    const auto disassembly = Util::removeAnsi(disassemblyWithAnsi.toString());
 
     const auto leftBracketIndex = disassembly.indexOf(QLatin1Char('<'));
     const auto rightBracketIndex = disassembly.indexOf(QLatin1Char('>'));
@@ -129,6 +182,79 @@ QString findBinaryForSymbol(const QStringList& debugPaths, const QStringList& ex
     return {};
 }
 
+struct ObjdumpRun
+{
+    enum Status
+    {
+        Finished,
+        FailedToStart,
+        Canceled,
+        TimedOut,
+    };
+    Status status = Finished;
+    QByteArray output;
+    QString errorOutput;
+    QString processError;
+};
+
+// this blocks until objdump finished, @p isCanceled gets polled meanwhile to kill objdump early
+ObjdumpRun runObjdump(const QString& processPath, const QStringList& arguments, const std::function<bool()>& isCanceled)
+{
+    ObjdumpRun run;
+
+    // NOTE: make sure to declare `run` before `asmProcess`, as when the latter gets destroyed it might
+    //       emit `readyRead` which then needs to access `run`, see also:
+    //       https://github.com/KDAB/hotspot/issues/542
+    QProcess asmProcess;
+    QObject::connect(&asmProcess, &QProcess::readyRead, [&asmProcess, &run]() {
+        run.output += asmProcess.readAllStandardOutput();
+        run.errorOutput += QString::fromStdString(asmProcess.readAllStandardError().toStdString());
+    });
+
+    asmProcess.start(processPath, arguments);
+
+    if (!asmProcess.waitForStarted()) {
+        run.status = ObjdumpRun::FailedToStart;
+        run.processError = asmProcess.errorString();
+        return run;
+    }
+
+    // wait in small steps, to kill objdump early when the result isn't needed anymore
+    QElapsedTimer timer;
+    timer.start();
+    bool finished = false;
+    while (!finished && timer.elapsed() < 30000) {
+        if (isCanceled && isCanceled()) {
+            asmProcess.kill();
+            asmProcess.waitForFinished();
+            run.status = ObjdumpRun::Canceled;
+            return run;
+        }
+        finished = asmProcess.waitForFinished(100);
+        if (!finished && asmProcess.state() == QProcess::NotRunning) {
+            // waitForFinished also returns false when the process already finished before
+            finished = true;
+        }
+    }
+
+    if (!finished) {
+        run.status = ObjdumpRun::TimedOut;
+    }
+    return run;
+}
+
+QString toHex(quint64 addr)
+{
+    return QLatin1String("0x") + QString::number(addr, 16);
+}
+
+QString findObjdump(const QString& objdump)
+{
+    if (!objdump.isEmpty() && QFile::exists(objdump))
+        return objdump;
+    return QStandardPaths::findExecutable(objdump);
+}
+
 bool isHexCharacter(QChar c)
 {
     return (c >= QLatin1Char('0') && c <= QLatin1Char('9')) || (c >= QLatin1Char('a') && c <= QLatin1Char('f'));
@@ -166,13 +292,31 @@ DisassemblyOutput::ObjectdumpOutput DisassemblyOutput::objdumpParse(const QByteA
 {
     QVector<DisassemblyOutput::DisassemblyLine> disassemblyLines;
 
-    QTextStream stream(output);
-    QString asmLine;
+    // decode the output at once and work on views of it, only the parts we keep get copied
+    const auto text = QString::fromUtf8(output);
+    qsizetype position = 0;
+    auto readLineInto = [&text, &position](QStringView* line) {
+        if (position >= text.size()) {
+            return false;
+        }
+        auto end = text.indexOf(QLatin1Char('\n'), position);
+        if (end == -1) {
+            end = text.size();
+        }
+        *line = QStringView(text).mid(position, end - position);
+        if (line->endsWith(QLatin1Char('\r'))) {
+            line->chop(1);
+        }
+        position = end + 1;
+        return true;
+    };
+
+    QStringView asmLine;
     QString sourceFileName;
     QString currentSourceFileName;
 
     int sourceCodeLine = -1;
-    while (stream.readLineInto(&asmLine)) {
+    while (readLineInto(&asmLine)) {
         if (asmLine.isEmpty())
             continue;
 
@@ -190,12 +334,13 @@ DisassemblyOutput::ObjectdumpOutput DisassemblyOutput::objdumpParse(const QByteA
             // -l add a line like:
             // main():
             // after 0000000000001090 <main>:
-            stream.readLine();
+            QStringView functionLine;
+            readLineInto(&functionLine);
             continue;
         }
 
         // we don't care about the file name
-        if (asmLine.startsWith(QLatin1Char('/')) && asmLine.contains(QStringLiteral("file format"))) {
+        if (asmLine.startsWith(QLatin1Char('/')) && asmLine.contains(QLatin1String("file format"))) {
             continue;
         } else if (asmLine.startsWith(QLatin1Char('/')) || asmLine.startsWith(QLatin1Char('.'))) {
             // extract source code line info
@@ -204,12 +349,12 @@ DisassemblyOutput::ObjectdumpOutput DisassemblyOutput::objdumpParse(const QByteA
             // - /usr/include/c++/11.2.0/bits/stl_tree.h:3452
             // - ././test.cpp
 
-            currentSourceFileName = asmLine.left(colonIndex);
+            currentSourceFileName = asmLine.left(colonIndex).toString();
             if (sourceFileName.isEmpty()) {
                 sourceFileName = currentSourceFileName;
             }
 
-            auto lineNumber = QStringView(asmLine).right(asmLine.length() - colonIndex - 1);
+            auto lineNumber = asmLine.right(asmLine.length() - colonIndex - 1);
             const auto spaceIndex = lineNumber.indexOf(QLatin1Char(' '));
             if (spaceIndex != -1) {
                 lineNumber = lineNumber.left(spaceIndex);
@@ -239,11 +384,12 @@ DisassemblyOutput::ObjectdumpOutput DisassemblyOutput::objdumpParse(const QByteA
             // we got a line like:
             // std::__cxx11::basic_string<char, std::char_traits<char>, std::allocator<char> >::_M_local_data():
             // pass them to the disassembler since this can be used for inlining
-            disassemblyLines.push_back({0, asmLine, {}, {}, {}, {currentSourceFileName, sourceCodeLine}});
+            disassemblyLines.push_back(
+                {0, asmLine.toString(), {}, {}, {}, {currentSourceFileName, sourceCodeLine}});
             continue;
         }
 
-        const auto addr = [addrString = QStringView(asmLine).mid(0, firstTab).trimmed(), &asmLine]() -> uint64_t {
+        const auto addr = [addrString = asmLine.mid(0, firstTab).trimmed(), asmLine]() -> uint64_t {
             const auto suffix = QLatin1Char(':');
             if (!addrString.endsWith(suffix))
                 return 0;
@@ -273,13 +419,11 @@ DisassemblyOutput::ObjectdumpOutput DisassemblyOutput::objdumpParse(const QByteA
             [branchesAndHex = asmLine.mid(firstTab + 1, secondTab - firstTab - 1)]() -> BranchesAndHexdump {
             auto firstHexIt = std::find_if(branchesAndHex.cbegin(), branchesAndHex.cend(), isHexCharacter);
             auto size = std::distance(branchesAndHex.cbegin(), firstHexIt);
-            auto branchVisualisation = branchesAndHex.mid(0, size);
-            auto hexdump = branchesAndHex.mid(size);
-            return {branchVisualisation, hexdump.trimmed()};
+            return {branchesAndHex.mid(0, size).toString(), branchesAndHex.mid(size).trimmed().toString()};
         }();
 
         disassemblyLines.push_back({addr,
-                                    asmLine.mid(secondTab + 1).trimmed(),
+                                    asmLine.mid(secondTab + 1).trimmed().toString(),
                                     branchVisualisation,
                                     hexdump,
                                     extractLinkedFunction(asmLine),
@@ -291,7 +435,7 @@ DisassemblyOutput::ObjectdumpOutput DisassemblyOutput::objdumpParse(const QByteA
 DisassemblyOutput DisassemblyOutput::disassemble(const QString& objdump, const QString& arch,
                                                  const QStringList& debugPaths, const QStringList& extraLibPaths,
                                                  const QStringList& sourceCodePaths, const QString& sysroot,
-                                                 const Data::Symbol& symbol)
+                                                 const Data::Symbol& symbol, const std::function<bool()>& isCanceled)
 {
     DisassemblyOutput disassemblyOutput;
     disassemblyOutput.symbol = symbol;
@@ -310,12 +454,6 @@ DisassemblyOutput DisassemblyOutput::disassemble(const QString& objdump, const Q
         return disassemblyOutput;
     }
 
-    auto findObjdump = [](const QString& objdump) {
-        if (!objdump.isEmpty() && QFile::exists(objdump))
-            return objdump;
-        return QStandardPaths::findExecutable(objdump);
-    };
-
     const auto processPath = findObjdump(objdump);
     if (processPath.isEmpty()) {
         disassemblyOutput.errorMessage =
@@ -326,57 +464,52 @@ DisassemblyOutput DisassemblyOutput::disassemble(const QString& objdump, const Q
         return disassemblyOutput;
     }
 
-    // NOTE: make sure to declare `output` before `asmProcess`, as when the latter gets destroyed it might
-    //       emit `readyRead` which then needs to access `output`, see also:
-    //       https://github.com/KDAB/hotspot/issues/542
-    QByteArray output;
-    QProcess asmProcess;
-    QObject::connect(&asmProcess, &QProcess::readyRead, [&asmProcess, &disassemblyOutput, &output]() {
-        output += asmProcess.readAllStandardOutput();
-        disassemblyOutput.errorMessage += QString::fromStdString(asmProcess.readAllStandardError().toStdString());
-    });
-
-    // Call objdump with arguments: addresses range and binary file
-    auto toHex = [](quint64 addr) -> QString { return QLatin1String("0x") + QString::number(addr, 16); };
-    auto arguments = QStringList {QStringLiteral("-d"), // disassemble
-                                  QStringLiteral("-l"), // include source code lines
-                                  QStringLiteral("-C"), // demangle names
-                                  QStringLiteral("--start-address"),
-                                  toHex(symbol.relAddr),
-                                  QStringLiteral("--stop-address"),
-                                  toHex(symbol.relAddr + symbol.size)};
-
-    // only available for objdump 2.34+
-    if (canVisualizeJumps(processPath))
-        arguments.append(QStringLiteral("--visualize-jumps"));
-    else
-        qCInfo(disassemblyoutput) << "objdump binary does not support `--visualize-jumps`:" << processPath;
-
-    if (canUseSyntaxHighlighting(processPath)) {
-        arguments.append(QStringLiteral("--disassembler-color=color"));
-    } else {
-        qCInfo(disassemblyoutput) << "objdump binary does not support `--disassembler-color`:" << processPath;
-    }
-
     auto binary = findBinaryForSymbol(debugPaths, extraLibPaths, symbol);
     if (binary.isEmpty()) {
         disassemblyOutput.errorMessage +=
             QApplication::translate("DisassemblyOutput", "<qt>Could not find binary <tt>%1</tt>.").arg(symbol.binary);
         return disassemblyOutput;
     }
-    arguments.append(binary);
 
-    asmProcess.start(processPath, arguments);
+    const auto cacheKey = DisassemblyCache::key(binary, symbol.relAddr, symbol.relAddr + symbol.size,
+                                                objdumpFlags(processPath));
+    auto setObjdumpOutput = [&](const ObjectdumpOutput& objdumpOutput) {
+        disassemblyOutput.disassemblyLines = objdumpOutput.disassemblyLines;
+        disassemblyOutput.mainSourceFileName = objdumpOutput.mainSourceFileName;
+        disassemblyOutput.realSourceFileName =
+            SourceFileCache::instance()->resolve(objdumpOutput.mainSourceFileName, sourceCodePaths, sysroot);
+        // load the source file while we are still in the background, the source view picks it up from the cache
+        if (!disassemblyOutput.realSourceFileName.isEmpty()) {
+            SourceFileCache::instance()->file(disassemblyOutput.realSourceFileName);
+        }
+    };
+    if (const auto cached = DisassemblyCache::instance()->find(cacheKey)) {
+        setObjdumpOutput(*cached);
+        return disassemblyOutput;
+    }
 
-    if (!asmProcess.waitForStarted()) {
+    // Call objdump with arguments: addresses range and binary file
+    auto arguments = cacheKey.objdumpFlags.mid(1);
+    arguments += {QStringLiteral("--start-address"), toHex(symbol.relAddr), QStringLiteral("--stop-address"),
+                  toHex(symbol.relAddr + symbol.size), binary};
+
+    const auto run = runObjdump(processPath, arguments, isCanceled);
+    disassemblyOutput.errorMessage += run.errorOutput;
+
+    switch (run.status) {
+    case ObjdumpRun::Finished:
+        break;
+    case ObjdumpRun::FailedToStart:
         disassemblyOutput.errorMessage +=
             QApplication::translate("DisassemblyOutput",
                                     "<qt>Process failed to start: <tt>%1 %2</tt> returned <tt>%3</tt>.")
-                .arg(processPath, arguments.join(QLatin1Char(' ')), asmProcess.errorString());
+                .arg(processPath, arguments.join(QLatin1Char(' ')), run.processError);
         return disassemblyOutput;
-    }
-
-    if (!asmProcess.waitForFinished()) {
+    case ObjdumpRun::Canceled:
+        disassemblyOutput.errorMessage +=
+            QApplication::translate("DisassemblyOutput", "<qt>Disassembly was canceled.");
+        return disassemblyOutput;
+    case ObjdumpRun::TimedOut:
         disassemblyOutput.errorMessage +=
             QApplication::translate("DisassemblyOutput",
                                     "<qt>Process not finished: <tt>%1 %2</tt>, stopped by timeout.")
@@ -384,16 +517,131 @@ DisassemblyOutput DisassemblyOutput::disassemble(const QString& objdump, const Q
         return disassemblyOutput;
     }
 
-    if (output.isEmpty()) {
+    if (run.output.isEmpty()) {
         disassemblyOutput.errorMessage +=
             QApplication::translate("DisassemblyOutput", "<qt>Empty output of command <tt>%1 %2</tt>.")
                 .arg(processPath, arguments.join(QLatin1Char(' ')));
     }
 
-    const auto objdumpOutput = objdumpParse(output);
-    disassemblyOutput.disassemblyLines = objdumpOutput.disassemblyLines;
-    disassemblyOutput.mainSourceFileName = objdumpOutput.mainSourceFileName;
-    disassemblyOutput.realSourceFileName =
-        findSourceCodeFile(objdumpOutput.mainSourceFileName, sourceCodePaths, sysroot);
+    const auto objdumpOutput = objdumpParse(run.output);
+    if (disassemblyOutput.errorMessage.isEmpty()) {
+        DisassemblyCache::instance()->insert(cacheKey, objdumpOutput);
+    }
+    setObjdumpOutput(objdumpOutput);
     return disassemblyOutput;
 }
+
+int DisassemblyOutput::prefetch(const QString& objdump, const QStringList& debugPaths, const QStringList& extraLibPaths,
+                                const QVector<Data::Symbol>& symbols, const std::function<bool()>& isCanceled)
+{
+    const auto processPath = findObjdump(objdump);
+    if (processPath.isEmpty()) {
+        return 0;
+    }
+
+    const auto flags = objdumpFlags(processPath);
+    auto* cache = DisassemblyCache::instance();
+
+    // group the symbols by binary, skipping everything that is cached already
+    QHash<QString, QString> binaries;
+    QHash<QString, QVector<Data::Symbol>> symbolsByBinary;
+    for (const auto& symbol : symbols) {
+        if (symbol.symbol.isEmpty() || symbol.relAddr == 0 || symbol.size == 0 || symbol.isInline) {
+            continue;
+        }
+
+        const auto binaryKey = symbol.actualPath + QLatin1Char('\n') + symbol.binary + QLatin1Char('\n') + symbol.path;
+        auto binaryIt = binaries.find(binaryKey);
+        if (binaryIt == binaries.end()) {
+            binaryIt = binaries.insert(binaryKey, findBinaryForSymbol(debugPaths, extraLibPaths, symbol));
+        }
+        const auto& binary = *binaryIt;
+        if (binary.isEmpty()
+            || cache->find(DisassemblyCache::key(binary, symbol.relAddr, symbol.relAddr + symbol.size, flags))) {
+            continue;
+        }
+        symbolsByBinary[binary].append(symbol);
+    }
+
+    // objdump only supports a single address range, so disassemble neighboring symbols in one run
+    // but split the symbols into multiple runs when they are too far apart from each other
+    const quint64 maxGap = 64 * 1024;
+
+    int numCached = 0;
+    for (auto it = symbolsByBinary.begin(); it != symbolsByBinary.end(); ++it) {
+        const auto& binary = it.key();
+        auto& binarySymbols = it.value();
+        std::sort(binarySymbols.begin(), binarySymbols.end(),
+                  [](const Data::Symbol& lhs, const Data::Symbol& rhs) { return lhs.relAddr < rhs.relAddr; });
+
+        for (int clusterStart = 0; clusterStart < binarySymbols.size();) {
+            if (isCanceled && isCanceled()) {
+                return numCached;
+            }
+
+            auto start = binarySymbols[clusterStart].relAddr;
+            auto end = start + binarySymbols[clusterStart].size;
+            int clusterEnd = clusterStart + 1;
+            while (clusterEnd < binarySymbols.size() && binarySymbols[clusterEnd].relAddr <= end + maxGap) {
+                end = std::max(end, binarySymbols[clusterEnd].relAddr + binarySymbols[clusterEnd].size);
+                ++clusterEnd;
+            }
+            const auto cluster = binarySymbols.mid(clusterStart, clusterEnd - clusterStart);
+            clusterStart = clusterEnd;
+
+            auto arguments = flags.mid(1);
+            arguments += {QStringLiteral("--start-address"), toHex(start), QStringLiteral("--stop-address"),
+                          toHex(end), binary};
+            const auto run = runObjdump(processPath, arguments, isCanceled);
+            if (run.status != ObjdumpRun::Finished || !run.errorOutput.isEmpty()) {
+                qCDebug(disassemblyoutput) << "failed to prefetch disassembly" << processPath << arguments
+                                           << run.processError << run.errorOutput;
+                continue;
+            }
+
+            // split the output into the lines of the individual symbols
+            // lines without an address belong to the next instruction, e.g. the name of an inlined function
+            QVector<ObjectdumpOutput> outputs(cluster.size());
+            QVector<DisassemblyLine> pendingLines;
+            int firstSymbol = 0;
+            for (const auto& line : objdumpParse(run.output).disassemblyLines) {
+                if (line.addr == 0) {
+                    pendingLines.append(line);
+                    continue;
+                }
+
+                while (firstSymbol < cluster.size()
+                       && cluster[firstSymbol].relAddr + cluster[firstSymbol].size <= line.addr) {
+                    ++firstSymbol;
+                }
+                for (int i = firstSymbol; i < cluster.size() && cluster[i].relAddr <= line.addr; ++i) {
+                    if (line.addr >= cluster[i].relAddr + cluster[i].size) {
+                        continue;
+                    }
+                    auto& output = outputs[i];
+                    output.disassemblyLines += pendingLines;
+                    output.disassemblyLines.append(line);
+                }
+                pendingLines.clear();
+            }
+
+            for (int i = 0; i < cluster.size(); ++i) {
+                auto& output = outputs[i];
+                if (output.disassemblyLines.isEmpty()) {
+                    continue;
+                }
+                // like for a single symbol, the main source file is the first one that is encountered
+                auto firstFileLine = std::find_if(output.disassemblyLines.cbegin(), output.disassemblyLines.cend(),
+                                                  [](const DisassemblyLine& line) { return line.fileLine.isValid(); });
+                if (firstFileLine != output.disassemblyLines.cend()) {
+                    output.mainSourceFileName = firstFileLine->fileLine.file;
+                }
+                const auto& symbol = cluster[i];
+                cache->insert(DisassemblyCache::key(binary, symbol.relAddr, symbol.relAddr + symbol.size, flags),
+                              output);
+                ++numCached;
+            }
+        }
+    }
+    return numCached;
+}
@@ -12,6 +12,8 @@
 
 #include "data.h"
 
+#include <functional>
+
 struct DisassemblyOutput
 {
     struct LinkedFunction
@@ -52,9 +54,16 @@ struct DisassemblyOutput
     };
     static ObjectdumpOutput objdumpParse(const QByteArray& objdumpOutput);
 
+    // this blocks until objdump finished, @p isCanceled gets polled meanwhile to abort early
     static DisassemblyOutput disassemble(const QString& objdump, const QString& arch, const QStringList& debugPaths,
                                          const QStringList& extraLibPaths, const QStringList& sourceCodePaths,
-                                         const QString& sysroot, const Data::Symbol& symbol);
+                                         const QString& sysroot, const Data::Symbol& symbol,
+                                         const std::function<bool()>& isCanceled = {});
+
+    // disassembles @p symbols with as few objdump runs as possible and stores the per-symbol results in the cache
+    // symbols that are cached already get skipped, returns the number of newly cached symbols
+    static int prefetch(const QString& objdump, const QStringList& debugPaths, const QStringList& extraLibPaths,
+                        const QVector<Data::Symbol>& symbols, const std::function<bool()>& isCanceled = {});
 };
 
 QString findSourceCodeFile(const QString& originalPath, const QStringList& sourceCodePaths, const QString& sysroot);
@@ -0,0 +1,113 @@
+/*
+    SPDX-FileCopyrightText: Milian Wolff <milian.wolff@kdab.com>
+    SPDX-FileCopyrightText: 2016 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "eventpyramid.h"
+
+#include <limits>
+
+namespace {
+void addToBin(EventPyramid::Bin* bin, const EventPyramid::Bin& rhs)
+{
+    bin->endTime = std::max(bin->endTime, rhs.endTime);
+    bin->totalCost += rhs.totalCost;
+    bin->maxCost = std::max(bin->maxCost, rhs.maxCost);
+    bin->numEvents += rhs.numEvents;
+}
+
+quint64 floorPowerOfTwo(quint64 value)
+{
+    quint64 ret = 1;
+    while (ret <= value / 2) {
+        ret *= 2;
+    }
+    return ret;
+}
+}
+
+EventPyramid::EventPyramid(const Data::Events& events, qint32 type)
+    : m_type(type)
+{
+    int numEvents = 0;
+    quint64 firstTime = 0;
+    quint64 lastTime = 0;
+    for (const auto& event : events) {
+        if (event.type != type) {
+            continue;
+        }
+        if (!numEvents) {
+            firstTime = event.time;
+        }
+        lastTime = event.time;
+        ++numEvents;
+    }
+    if (numEvents < 2) {
+        return;
+    }
+
+    // below the average distance between two events, nearly every bin would only hold a single event
+    auto binWidth = floorPowerOfTwo(std::max<quint64>(1, (lastTime - firstTime) / numEvents));
+
+    // the bins of the candidate level reference the last level that got stored, or the events for level zero
+    Bins candidate;
+    for (int i = 0, c = events.size(); i < c; ++i) {
+        const auto& event = events[i];
+        if (event.type != type) {
+            continue;
+        }
+        Bin bin;
+        bin.time = event.time;
+        bin.endTime = event.time + event.cost;
+        bin.totalCost = event.cost;
+        bin.maxCost = event.cost;
+        bin.numEvents = 1;
+        bin.first = i;
+        if (!candidate.isEmpty() && candidate.last().time / binWidth == bin.time / binWidth) {
+            addToBin(&candidate.last(), bin);
+        } else {
+            candidate.append(bin);
+        }
+    }
+
+    qsizetype lastStoredSize = numEvents;
+    while (true) {
+        // only store levels that are considerably coarser than the previous one
+        const bool store = candidate.size() * 2 <= lastStoredSize;
+        if (store) {
+            lastStoredSize = candidate.size();
+            m_levels.append(Level{binWidth, candidate});
+        }
+        if (candidate.size() <= 1 || binWidth > std::numeric_limits<quint64>::max() / 2) {
+            break;
+        }
+
+        binWidth *= 2;
+        Bins next;
+        next.reserve(candidate.size() / 2 + 1);
+        for (int i = 0, c = candidate.size(); i < c; ++i) {
+            auto bin = candidate[i];
+            if (store) {
+                bin.first = i;
+            }
+            if (!next.isEmpty() && next.last().time / binWidth == bin.time / binWidth) {
+                addToBin(&next.last(), bin);
+            } else {
+                next.append(bin);
+            }
+        }
+        candidate = std::move(next);
+    }
+}
+
+int EventPyramid::levelForResolution(double timePerPixel) const
+{
+    for (int level = m_levels.size() - 1; level >= 0; --level) {
+        if (static_cast<double>(m_levels[level].binWidth) <= timePerPixel) {
+            return level;
+        }
+    }
+    return -1;
+}
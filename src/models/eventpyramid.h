@@ -0,0 +1,105 @@
+/*
+    SPDX-FileCopyrightText: Milian Wolff <milian.wolff@kdab.com>
+    SPDX-FileCopyrightText: 2016 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QBitArray>
+#include <QVector>
+
+#include "data.h"
+
+/**
+ * Multi-resolution summary of the events of one type in a time-sorted event list.
+ *
+ * Every level groups the events into bins of a power-of-two width in nanoseconds,
+ * each level being at least twice as coarse as the previous one. Only non-empty
+ * bins are stored. This allows the timeline to paint a row in time proportional
+ * to the number of visible pixels, instead of the number of events.
+ */
+class EventPyramid
+{
+public:
+    struct Bin
+    {
+        // time of the first event in this bin
+        quint64 time = 0;
+        // latest end time, i.e. time + cost, of any event in this bin
+        quint64 endTime = 0;
+        quint64 totalCost = 0;
+        quint64 maxCost = 0;
+        quint32 numEvents = 0;
+        // index of the first event (for level zero) or the first bin of the next finer level within this bin
+        quint32 first = 0;
+    };
+    using Bins = QVector<Bin>;
+    // one bit per bin for every level
+    using Mask = QVector<QBitArray>;
+
+    EventPyramid() = default;
+    EventPyramid(const Data::Events& events, qint32 type);
+
+    qint32 type() const
+    {
+        return m_type;
+    }
+
+    int numLevels() const
+    {
+        return m_levels.size();
+    }
+
+    quint64 binWidth(int level) const
+    {
+        return m_levels[level].binWidth;
+    }
+
+    const Bins& bins(int level) const
+    {
+        return m_levels[level].bins;
+    }
+
+    // returns the coarsest level whose bins are not wider than @p timePerPixel
+    // or -1 when the events are sparse enough to be used directly at that resolution
+    int levelForResolution(double timePerPixel) const;
+
+    // marks all bins that contain an event for which @p isHighlighted returns true for its stack id
+    // @p events must be the events this pyramid was built from
+    template<typename Predicate>
+    Mask highlightMask(const Data::Events& events, const Predicate& isHighlighted) const
+    {
+        Mask mask;
+        mask.reserve(m_levels.size());
+        for (int level = 0; level < m_levels.size(); ++level) {
+            const auto& bins = m_levels[level].bins;
+            QBitArray bits(bins.size());
+            for (qsizetype i = 0, c = bins.size(); i < c; ++i) {
+                const qsizetype first = bins[i].first;
+                const qsizetype last = i + 1 < c ? bins[i + 1].first : (level ? mask.last().size() : events.size());
+                for (auto j = first; j < last; ++j) {
+                    if (level ? mask.last().testBit(j)
+                              : (events[j].type == m_type && isHighlighted(events[j].stackId))) {
+                        bits.setBit(i);
+                        break;
+                    }
+                }
+            }
+            mask.append(bits);
+        }
+        return mask;
+    }
+
+private:
+    struct Level
+    {
+        quint64 binWidth = 0;
+        Bins bins;
+    };
+    QVector<Level> m_levels;
+    qint32 m_type = -1;
+};
+
+Q_DECLARE_TYPEINFO(EventPyramid::Bin, Q_MOVABLE_TYPE);
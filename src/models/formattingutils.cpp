@@ -13,11 +13,24 @@ QString Util::removeAnsi(const QString& stringWithAnsi)
         return stringWithAnsi;
     }
 
-    QString ansiFreeString = stringWithAnsi;
-    while (ansiFreeString.contains(escapeChar)) {
-        const auto escapeStart = ansiFreeString.indexOf(escapeChar);
-        const auto escapeEnd = ansiFreeString.indexOf(QLatin1Char('m'), escapeStart);
-        ansiFreeString.remove(escapeStart, escapeEnd - escapeStart + 1);
+    // copy the text between the escape sequences in a single pass, the sequences end with an 'm'
+    QString ansiFreeString;
+    ansiFreeString.reserve(stringWithAnsi.size());
+    qsizetype position = 0;
+    while (position < stringWithAnsi.size()) {
+        const auto escapeStart = stringWithAnsi.indexOf(escapeChar, position);
+        if (escapeStart == -1) {
+            ansiFreeString.append(QStringView(stringWithAnsi).mid(position));
+            break;
+        }
+        ansiFreeString.append(QStringView(stringWithAnsi).mid(position, escapeStart - position));
+
+        const auto escapeEnd = stringWithAnsi.indexOf(QLatin1Char('m'), escapeStart);
+        if (escapeEnd == -1) {
+            // unterminated sequence, drop the rest
+            break;
+        }
+        position = escapeEnd + 1;
     }
     return ansiFreeString;
 }
@@ -0,0 +1,91 @@
+/*
+    SPDX-FileCopyrightText: Milian Wolff <milian.wolff@kdab.com>
+    SPDX-FileCopyrightText: 2016 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "frequencypyramid.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace {
+constexpr int binFactor = 4;
+
+void addToBin(FrequencyPyramid::Bin* bin, const FrequencyPyramid::Bin& rhs)
+{
+    bin->endTime = rhs.endTime;
+    bin->minValue = std::min(bin->minValue, rhs.minValue);
+    bin->maxValue = std::max(bin->maxValue, rhs.maxValue);
+    bin->sumValue += rhs.sumValue;
+    bin->numValues += rhs.numValues;
+}
+
+template<typename Container, typename ToBin>
+FrequencyPyramid::Bins mergeBins(const Container& input, const ToBin& toBin)
+{
+    FrequencyPyramid::Bins bins;
+    bins.reserve(input.size() / binFactor + 1);
+    for (qsizetype i = 0, c = input.size(); i < c; ++i) {
+        const auto bin = toBin(input[i]);
+        if (i % binFactor) {
+            addToBin(&bins.last(), bin);
+        } else {
+            bins.append(bin);
+        }
+    }
+    return bins;
+}
+}
+
+FrequencyPyramid::FrequencyPyramid(QVector<Data::FrequencyData> values)
+    : m_values(std::move(values))
+{
+    if (m_values.size() <= binFactor) {
+        return;
+    }
+
+    m_levels.append(mergeBins(m_values, [](const Data::FrequencyData& value) {
+        return Bin {value.time, value.time, value.cost, value.cost, value.cost, 1};
+    }));
+    while (m_levels.last().size() > binFactor) {
+        m_levels.append(mergeBins(m_levels.last(), [](const Bin& bin) { return bin; }));
+    }
+}
+
+QVector<Data::FrequencyData> FrequencyPyramid::decimate(quint64 start, quint64 end, int numPixels) const
+{
+    QVector<Data::FrequencyData> points;
+
+    const auto [firstValue, lastValue] = Data::findTimeRange(m_values, Data::TimeRange(start, end));
+    if (std::distance(firstValue, lastValue) <= numPixels || m_levels.isEmpty()) {
+        std::copy(firstValue, lastValue, std::back_inserter(points));
+        return points;
+    }
+
+    // use the finest level that has at most one bin per pixel, or the coarsest one
+    for (const auto& bins : m_levels) {
+        const auto firstBin =
+            std::partition_point(bins.begin(), bins.end(), [start](const Bin& bin) { return bin.endTime < start; });
+        const auto lastBin =
+            std::partition_point(firstBin, bins.end(), [end](const Bin& bin) { return bin.time <= end; });
+        if (std::distance(firstBin, lastBin) > numPixels && &bins != &m_levels.last()) {
+            continue;
+        }
+
+        points.reserve(std::distance(firstBin, lastBin) * 3);
+        for (auto it = firstBin; it != lastBin; ++it) {
+            const auto time = it->time + (it->endTime - it->time) / 2;
+            points.append({time, it->minValue});
+            if (it->maxValue != it->minValue) {
+                points.append({time, it->maxValue});
+            }
+            if (it->numValues > 2) {
+                points.append({time, it->meanValue()});
+            }
+        }
+        break;
+    }
+    return points;
+}
@@ -0,0 +1,71 @@
+/*
+    SPDX-FileCopyrightText: Milian Wolff <milian.wolff@kdab.com>
+    SPDX-FileCopyrightText: 2016 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QVector>
+
+#include "data.h"
+
+/**
+ * Level-of-detail summary of a time-sorted frequency series.
+ *
+ * Level zero are the values themselves, every further level merges four consecutive
+ * bins of the previous one and remembers their minimum, maximum and mean. This allows
+ * the frequency plot to only get the points that are distinguishable at the current
+ * zoom level, independent of the number of samples.
+ */
+class FrequencyPyramid
+{
+public:
+    struct Bin
+    {
+        quint64 time = 0;
+        quint64 endTime = 0;
+        double minValue = 0;
+        double maxValue = 0;
+        double sumValue = 0;
+        quint32 numValues = 0;
+
+        double meanValue() const
+        {
+            return numValues ? sumValue / numValues : 0.;
+        }
+    };
+    using Bins = QVector<Bin>;
+
+    FrequencyPyramid() = default;
+    // @p values must be sorted by time
+    explicit FrequencyPyramid(QVector<Data::FrequencyData> values);
+
+    const QVector<Data::FrequencyData>& values() const
+    {
+        return m_values;
+    }
+
+    // number of levels, including the values as level zero
+    int numLevels() const
+    {
+        return m_levels.size() + 1;
+    }
+
+    // bins of @p level, which must be at least one
+    const Bins& bins(int level) const
+    {
+        return m_levels[level - 1];
+    }
+
+    // returns the points to plot for the time range [@p start, @p end] when it is @p numPixels wide
+    // for every bin, its minimum and maximum are kept so that outliers stay visible, next to its mean
+    QVector<Data::FrequencyData> decimate(quint64 start, quint64 end, int numPixels) const;
+
+private:
+    QVector<Data::FrequencyData> m_values;
+    QVector<Bins> m_levels;
+};
+
+Q_DECLARE_TYPEINFO(FrequencyPyramid::Bin, Q_MOVABLE_TYPE);
@@ -10,6 +10,10 @@
 #include <QAbstractTableModel>
 #include <QHash>
 #include <QVector>
+#include <QtConcurrent/QtConcurrentMap>
+
+#include <algorithm>
+#include <numeric>
 
 template<typename Rows, typename ModelImpl>
 class HashModel : public QAbstractTableModel
@@ -68,6 +72,12 @@ public:
         return m_keys.value(row);
     }
 
+    // the position of @p row when sorted by the costs in @p column, the most expensive row has rank zero
+    int costRank(int row, int column) const
+    {
+        return m_costRanks[column - ModelImpl::NUM_BASE_COLUMNS][row];
+    }
+
 protected:
     void setRows(const Rows& rows)
     {
@@ -80,10 +90,35 @@ protected:
             m_keys.push_back(it.key());
             m_values.push_back(it.value());
         }
+
+        // sorting by a cost column then only needs to compare integers, instead of reading costs through QVariant
+        QVector<int> columns(numColumns() - ModelImpl::NUM_BASE_COLUMNS);
+        std::iota(columns.begin(), columns.end(), ModelImpl::NUM_BASE_COLUMNS);
+        m_costRanks =
+            QtConcurrent::blockingMapped<QVector<QVector<int>>>(columns, [this](int column) { return costRanks(column); });
         endResetModel();
     }
 
 private:
+    QVector<int> costRanks(int column) const
+    {
+        const int numRows = m_keys.size();
+        QVector<qint64> costs(numRows);
+        for (int row = 0; row < numRows; ++row) {
+            costs[row] = cell(column, ModelImpl::SortRole, m_keys[row], m_values[row]).toLongLong();
+        }
+
+        QVector<int> byCost(numRows);
+        std::iota(byCost.begin(), byCost.end(), 0);
+        std::stable_sort(byCost.begin(), byCost.end(), [&costs](int lhs, int rhs) { return costs[lhs] > costs[rhs]; });
+
+        QVector<int> ranks(numRows);
+        for (int rank = 0; rank < numRows; ++rank) {
+            ranks[byCost[rank]] = rank;
+        }
+        return ranks;
+    }
+
     virtual QVariant headerCell(int column, int role) const = 0;
     virtual QVariant cell(int column, int role, const typename Rows::key_type& key,
                           const typename Rows::mapped_type& entry) const = 0;
@@ -91,4 +126,6 @@ private:
 
     QVector<typename Rows::key_type> m_keys;
     QVector<typename Rows::mapped_type> m_values;
+    // for every cost column, maps rows to their position when sorted by that column
+    QVector<QVector<int>> m_costRanks;
 };
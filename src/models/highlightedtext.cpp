@@ -7,6 +7,7 @@
 
 #include "highlightedtext.h"
 
+#include <QCache>
 #include <QFontMetrics>
 #include <QGuiApplication>
 #include <QPalette>
@@ -32,6 +33,15 @@
 
 using LineFormat = QVector<QTextLayout::FormatRange>;
 
+namespace {
+// the highlighter state is remembered every this many lines, formats are computed and cached in chunks of that size
+constexpr int checkpointInterval = 128;
+// upper limit for the number of lines with cached formats
+constexpr int maxFormattedLines = 16 * 1024;
+// upper limit for the number of lines with a QTextLayout, which should be well above the number of visible lines
+constexpr std::size_t maxLayouts = 4096;
+}
+
 #if KFSyntaxHighlighting_FOUND
 // highlighter using KSyntaxHighlighting
 class HighlightingImplementation : public KSyntaxHighlighting::AbstractHighlighter
@@ -45,21 +55,53 @@ public:
 
     void formatText(const QStringList& text)
     {
-        if (m_lines != text) {
-            m_lines = text;
+        m_lines = text;
+        resetFormats();
+    }
+
+    // highlighting is done lazily, for the chunk of lines that contains @p lineIndex
+    // the highlighter state is carried forward from the closest checkpoint
+    LineFormat format(int lineIndex)
+    {
+        const int chunk = lineIndex / checkpointInterval;
+        if (const auto* formats = m_formats.object(chunk)) {
+            return formats->at(lineIndex % checkpointInterval);
         }
 
-        m_formats.clear();
-        m_state = {};
+        auto highlightChunk = [this](int chunk, QVector<LineFormat>* formats) {
+            const auto end = std::min<qsizetype>((chunk + 1) * checkpointInterval, m_lines.size());
+            for (auto i = chunk * checkpointInterval; i < end; ++i) {
+                auto format = formatLine(m_lines[i]);
+                if (formats) {
+                    formats->push_back(std::move(format));
+                }
+            }
+            if (chunk + 1 == m_checkpoints.size() && end < m_lines.size()) {
+                m_checkpoints.push_back(m_state);
+            }
+        };
 
-        for (const auto& line : text) {
-            m_formats.push_back(formatLine(line));
+        // only the checkpoints are kept for the lines before the requested chunk
+        int knownChunk = std::min<int>(m_checkpoints.size() - 1, chunk);
+        m_state = m_checkpoints[knownChunk];
+        for (; knownChunk < chunk; ++knownChunk) {
+            highlightChunk(knownChunk, nullptr);
         }
+
+        auto formats = std::make_unique<QVector<LineFormat>>();
+        formats->reserve(checkpointInterval);
+        highlightChunk(chunk, formats.get());
+        const auto lineFormat = formats->value(lineIndex % checkpointInterval);
+        const auto cost = formats->size();
+        m_formats.insert(chunk, formats.release(), cost);
+        return lineFormat;
     }
 
-    virtual LineFormat format(int lineIndex) const
+    void resetFormats()
     {
-        return m_formats.at(lineIndex);
+        m_formats.clear();
+        m_checkpoints = {KSyntaxHighlighting::State()};
+        m_state = {};
     }
 
     virtual void themeChanged()
@@ -110,7 +152,9 @@ private:
     KSyntaxHighlighting::State m_state;
     QStringList m_lines; // for reformatting if definition changes
     LineFormat m_lineFormat;
-    QVector<LineFormat> m_formats;
+    // the state at the start of every checkpointInterval-th line
+    QVector<KSyntaxHighlighting::State> m_checkpoints = {KSyntaxHighlighting::State()};
+    QCache<int, QVector<LineFormat>> m_formats {maxFormattedLines};
 };
 #else
 // stub in case KSyntaxHighlighting is not available
@@ -122,18 +166,17 @@ public:
 
     void formatText(const QStringList& text)
     {
-        m_formats.clear();
-
-        for (const auto& line : text) {
-            m_formats.push_back(formatLine(line));
-        }
+        m_lines = text;
     }
 
-    LineFormat format(int lineIndex) const
+    // the lines are formatted independently of each other, so this can simply be done on demand
+    LineFormat format(int lineIndex)
     {
-        return m_formats.at(lineIndex);
+        return formatLine(m_lines.at(lineIndex));
     }
 
+    void resetFormats() { }
+
     virtual void themeChanged() { }
 
     virtual void setHighlightingDefinition(const KSyntaxHighlighting::Definition& /*definition*/) { }
@@ -150,7 +193,7 @@ private:
     }
 
     Q_DISABLE_COPY(HighlightingImplementation)
-    QVector<LineFormat> m_formats;
+    QStringList m_lines;
 };
 #endif
 
@@ -234,9 +277,9 @@ class HighlightedLine
 {
 public:
     HighlightedLine() = default;
-    HighlightedLine(HighlightingImplementation* highlighter, const QString& text, int index)
+    HighlightedLine(HighlightingImplementation* highlighter, const QString& cleanedText, int index)
         : m_highlighter(highlighter)
-        , m_text(Util::removeAnsi(text))
+        , m_text(cleanedText)
         , m_index(index)
         , m_layout(nullptr)
     {
@@ -250,6 +293,17 @@ public:
         return m_layout.get();
     }
 
+    bool hasLayout() const
+    {
+        return m_layout != nullptr;
+    }
+
+    // the layout is a cache, so releasing it is fine for const objects too
+    void releaseLayout() const
+    {
+        m_layout = nullptr;
+    }
+
     void updateHighlighting()
     {
         m_layout = nullptr;
@@ -322,18 +376,22 @@ void HighlightedText::setText(const QStringList& text)
         emit usesAnsiChanged(usesAnsi);
     }
 
-    m_highlightedLines.resize(text.size());
+    m_cleanedLines = text;
+    if (usesAnsi) {
+        std::transform(m_cleanedLines.begin(), m_cleanedLines.end(), m_cleanedLines.begin(), Util::removeAnsi);
+    }
+
+    // the highlighting happens lazily once a line gets shown
     m_highlighter->formatText(text);
+    m_highlightedLines.resize(text.size());
     int index = 0;
-    std::transform(text.cbegin(), text.cend(), m_highlightedLines.begin(), [this, &index](const QString& text) {
-        return HighlightedLine {m_highlighter.get(), text, index++};
-    });
+    std::transform(m_cleanedLines.cbegin(), m_cleanedLines.cend(), m_highlightedLines.begin(),
+                   [this, &index](const QString& cleanedText) {
+                       return HighlightedLine {m_highlighter.get(), cleanedText, index++};
+                   });
 
     // this is free since we currently have no text rendered
     updateTabWidth(m_tabWidth);
-
-    m_cleanedLines = text;
-    std::transform(m_cleanedLines.begin(), m_cleanedLines.end(), m_cleanedLines.begin(), Util::removeAnsi);
 }
 
 void HighlightedText::setDefinition(const KSyntaxHighlighting::Definition& definition)
@@ -354,8 +412,21 @@ QString HighlightedText::textAt(int index) const
 
 QTextLine HighlightedText::lineAt(int index) const
 {
-    auto& line = m_highlightedLines[index];
-    return line.layout()->lineAt(0);
+    return layout(index)->lineAt(0);
+}
+
+QTextLayout* HighlightedText::layout(int index) const
+{
+    const auto& line = m_highlightedLines[index];
+    if (!line.hasLayout()) {
+        // drop the oldest layouts, so that huge files don't keep a layout for every line that was ever shown
+        if (m_layoutLines.size() >= maxLayouts) {
+            m_highlightedLines[m_layoutLines.front()].releaseLayout();
+            m_layoutLines.pop_front();
+        }
+        m_layoutLines.push_back(index);
+    }
+    return line.layout();
 }
 
 QString HighlightedText::definition() const
@@ -367,13 +438,17 @@ QString HighlightedText::definition() const
 
 QTextLayout* HighlightedText::layoutForLine(int index)
 {
-    return m_highlightedLines[index].layout();
+    return layout(index);
 }
 
 void HighlightedText::updateHighlighting()
 {
-    if (m_highlighter)
+    if (m_highlighter) {
         m_highlighter->themeChanged();
+        // the cached formats contain the colors of the old theme
+        m_highlighter->resetFormats();
+    }
+    m_layoutLines.clear();
     std::for_each(m_highlightedLines.begin(), m_highlightedLines.end(),
                   [](HighlightedLine& line) { line.updateHighlighting(); });
 }
@@ -384,6 +459,7 @@ void HighlightedText::updateTabWidth(int tabWidth)
     auto font = QFontDatabase::systemFont(QFontDatabase::FixedFont);
     const auto tabWidthInPixels = tabWidth * QFontMetrics(font).horizontalAdvance(QLatin1Char(' '));
 
+    m_layoutLines.clear();
     std::for_each(m_highlightedLines.begin(), m_highlightedLines.end(),
                   [tabWidthInPixels](HighlightedLine& line) { line.setTabWidthInPixels(tabWidthInPixels); });
 }
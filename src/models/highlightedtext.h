@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <deque>
 #include <memory>
 
 #include <QObject>
@@ -54,9 +55,13 @@ public slots:
     void updateTabWidth(int tabWidth);
 
 private:
+    QTextLayout* layout(int index) const;
+
     KSyntaxHighlighting::Repository* m_repository;
     std::unique_ptr<HighlightingImplementation> m_highlighter;
     std::vector<HighlightedLine> m_highlightedLines;
+    // the lines that currently have a layout, oldest first
+    mutable std::deque<int> m_layoutLines;
     QStringList m_lines;
     QStringList m_cleanedLines;
     bool m_isUsingAnsi = false;
@@ -41,10 +41,15 @@ struct ProcData
     QString name;
     QString state;
     QString user;
+    // start time of the process in clock ticks after boot, to notice when a pid got reused
+    quint64 startTime = 0;
+    // the executable name from /proc/<pid>/stat, to notice when a process called exec
+    QString comm;
 
     bool equals(const ProcData& other) const
     {
-        return ppid == other.ppid && name == other.name && state == other.state && user == other.user;
+        return ppid == other.ppid && name == other.name && state == other.state && user == other.user
+            && startTime == other.startTime && comm == other.comm;
     }
 };
 Q_DECLARE_TYPEINFO(ProcData, Q_MOVABLE_TYPE);
@@ -62,4 +67,7 @@ inline bool operator==(const ProcData& l, const ProcData& r)
 QDebug operator<<(QDebug d, const ProcData& data);
 
 using ProcDataList = QVector<ProcData>;
-ProcDataList processList();
+// returns the running processes, sorted by pid
+// the command line of processes that are already contained in @p previous with the same start time and executable
+// is not read again, the owner is always looked up as it can change, but user names are only resolved once per uid
+ProcDataList processList(const ProcDataList& previous = {});
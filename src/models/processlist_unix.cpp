@@ -34,6 +34,8 @@
 
 #include <QDebug>
 #include <QDir>
+#include <QFileInfo>
+#include <QHash>
 #include <QProcess>
 
 #include <algorithm>
@@ -42,7 +44,7 @@
 QDebug operator<<(QDebug d, const ProcData& data)
 {
     d << "ProcData{.ppid=" << data.ppid << ", .name=" << data.name << ", .state=" << data.state
-      << ", .user=" << data.user << ", .type="
+      << ", .user=" << data.user << ", .startTime=" << data.startTime
       << "}";
     return d;
 }
@@ -97,14 +99,26 @@ ProcDataList unixProcessListPS()
 
 // Determine UNIX processes by reading "/proc". Default to ps if
 // it does not exist
-ProcDataList processList()
+ProcDataList processList(const ProcDataList& previous)
 {
     const QDir procDir(QStringLiteral("/proc/"));
-    if (!procDir.exists())
-        return unixProcessListPS();
+    if (!procDir.exists()) {
+        auto rc = unixProcessListPS();
+        std::stable_sort(rc.begin(), rc.end());
+        return rc;
+    }
+
+    QHash<QString, const ProcData*> knownProcesses;
+    knownProcesses.reserve(previous.size());
+    for (const auto& proc : previous) {
+        knownProcesses.insert(proc.ppid, &proc);
+    }
+    // looking up the user name is expensive, and most processes belong to only a few users
+    QHash<uint, QString> userNames;
 
     ProcDataList rc;
-    const auto entries = procDir.entryList();
+    const auto entries = procDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Unsorted);
+    rc.reserve(entries.size());
     for (const QString& procId : entries) {
         if (!isUnixProcessId(procId))
             continue;
@@ -113,20 +127,41 @@ ProcDataList processList()
         if (!file.open(QIODevice::ReadOnly))
             continue; // process may have exited
 
-        const QStringList data = QString::fromLocal8Bit(file.readAll()).split(QLatin1Char(' '));
+        // the name is in parentheses and may contain spaces or parentheses itself
+        const auto stat = QString::fromLocal8Bit(file.readAll());
+        const auto nameStart = stat.indexOf(QLatin1Char('('));
+        const auto nameEnd = stat.lastIndexOf(QLatin1Char(')'));
+        if (nameStart < 0 || nameEnd < nameStart)
+            continue;
+        // the fields after the name start with the state (field 3), the start time is field 22
+        const auto fields = QStringView(stat).mid(nameEnd + 2).split(QLatin1Char(' '));
+        if (fields.size() < 20)
+            continue;
+
         ProcData proc;
         proc.ppid = procId;
-        proc.name = data.at(1);
-        if (proc.name.startsWith(QLatin1Char('(')) && proc.name.endsWith(QLatin1Char(')'))) {
-            proc.name.truncate(proc.name.size() - 1);
-            proc.name.remove(0, 1);
-        }
-        proc.state = data.at(2);
-        // PPID is element 3
+        proc.state = fields[0].toString();
+        proc.startTime = fields[19].toULongLong();
+        proc.comm = stat.mid(nameStart + 1, nameEnd - nameStart - 1);
 
-        proc.user = QFileInfo(file).owner();
+        // the owner changes with a setuid exec, but thanks to userNames this is just a stat call
+        const auto ownerId = QFileInfo(file).ownerId();
+        auto user = userNames.find(ownerId);
+        if (user == userNames.end())
+            user = userNames.insert(ownerId, QFileInfo(file).owner());
+        proc.user = *user;
         file.close();
 
+        // the command line only needs to be read again when the pid got reused or the process called exec
+        const auto known = knownProcesses.value(procId);
+        if (known && known->startTime == proc.startTime && known->comm == proc.comm) {
+            proc.name = known->name;
+            rc.push_back(proc);
+            continue;
+        }
+
+        proc.name = proc.comm;
+
         QFile cmdFile(QLatin1String("/proc/") + procId + QLatin1String("/cmdline"));
         if (cmdFile.open(QFile::ReadOnly)) {
             QByteArray cmd = cmdFile.readAll();
@@ -138,5 +173,8 @@ ProcDataList processList()
 
         rc.push_back(proc);
     }
+
+    // sort here, so that the model doesn't have to do it in the GUI thread
+    std::sort(rc.begin(), rc.end());
     return rc;
 }
@@ -30,46 +30,56 @@ void ProcessModel::setProcesses(const ProcDataList& processes)
 
 void ProcessModel::mergeProcesses(const ProcDataList& processes)
 {
-    // sort like m_data
+    // sort like m_data, processList already does that in the background
     ProcDataList sortedProcesses = processes;
-    std::stable_sort(sortedProcesses.begin(), sortedProcesses.end());
+    if (!std::is_sorted(sortedProcesses.cbegin(), sortedProcesses.cend())) {
+        std::stable_sort(sortedProcesses.begin(), sortedProcesses.end());
+    }
 
+    // walk both lists and apply the differences as ranges of removed and inserted rows
     // iterator over m_data
     int i = 0;
+    // iterator over sortedProcesses
+    int j = 0;
+    const int numProcesses = sortedProcesses.size();
+    while (i < m_data.size() || j < numProcesses) {
+        // remove old procs, seems they are outdated
+        int end = i;
+        while (end < m_data.size() && (j == numProcesses || m_data.at(end) < sortedProcesses.at(j))) {
+            ++end;
+        }
+        if (end > i) {
+            beginRemoveRows(QModelIndex(), i, end - 1);
+            m_data.remove(i, end - i);
+            endRemoveRows();
+            continue;
+        }
 
-    for (const ProcData& newProc : sortedProcesses) {
-        bool shouldInsert = true;
-        while (i < m_data.count()) {
-            const ProcData& oldProc = m_data.at(i);
-            if (oldProc < newProc) {
-                // remove old proc, seems to be outdated
-                beginRemoveRows(QModelIndex(), i, i);
-                m_data.removeAt(i);
-                endRemoveRows();
-                continue;
-            } else if (newProc == oldProc) {
-                // already contained, hence increment and break.
-                // Update entry before if something changed (like state),
-                // this make sure m_data match exactly sortedProcesses for later Q_ASSERT check.
-                if (!newProc.equals(oldProc)) {
-                    m_data[i] = newProc;
-                    emit dataChanged(index(i, 0), index(i, columnCount() - 1));
-                }
-                ++i;
-                shouldInsert = false;
-                break;
-            } else { // newProc < oldProc
-                // new entry, break and insert it
-                break;
-            }
+        // insert new procs
+        end = j;
+        while (end < numProcesses && (i == m_data.size() || sortedProcesses.at(end) < m_data.at(i))) {
+            ++end;
         }
-        if (shouldInsert) {
-            beginInsertRows(QModelIndex(), i, i);
-            m_data.insert(i, newProc);
+        if (end > j) {
+            const int count = end - j;
+            beginInsertRows(QModelIndex(), i, i + count - 1);
+            m_data.insert(i, count, ProcData());
+            std::copy(sortedProcesses.cbegin() + j, sortedProcesses.cbegin() + end, m_data.begin() + i);
             endInsertRows();
-            // let i point to old element again
-            ++i;
+            // let i point to the old element again
+            i += count;
+            j = end;
+            continue;
+        }
+
+        // already contained, update the entry if something changed (like state)
+        // this make sure m_data matches exactly sortedProcesses for the later Q_ASSERT check
+        if (!sortedProcesses.at(j).equals(m_data.at(i))) {
+            m_data[i] = sortedProcesses.at(j);
+            emit dataChanged(index(i, 0), index(i, columnCount() - 1));
         }
+        ++i;
+        ++j;
     }
 
     // make sure the new data is properly inserted
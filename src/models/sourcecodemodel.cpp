@@ -8,7 +8,6 @@
 #include "sourcecodemodel.h"
 
 #include <QDir>
-#include <QFile>
 #include <QLoggingCategory>
 #include <QScopeGuard>
 #include <QTextBlock>
@@ -19,6 +18,7 @@
 #include <limits>
 
 #include "search.h"
+#include "sourcefilecache.h"
 #include <climits>
 
 namespace {
@@ -112,16 +112,17 @@ void SourceCodeModel::setDisassembly(const DisassemblyOutput& disassemblyOutput,
 
     m_prettySymbol = disassemblyOutput.symbol.prettySymbol;
 
-    QFile file(disassemblyOutput.realSourceFileName);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+    const auto sourceFile = SourceFileCache::instance()->file(disassemblyOutput.realSourceFileName);
+    if (!sourceFile) {
         return;
     }
 
-    const auto sourceCode = QString::fromUtf8(file.readAll());
-
-    m_lines = sourceCode.split(QLatin1Char('\n'));
-
-    m_highlightedText.setText(m_lines);
+    // the lines after the function are never shown, the ones before are needed for the highlighting state
+    const auto lines = sourceFile->lines(0, maxLineNumber);
+    if (lines != m_lines) {
+        m_lines = lines;
+        m_highlightedText.setText(m_lines);
+    }
 
     m_startLine = std::min<int>(m_lines.size(), minLineNumber - 1); // convert to index
     m_numLines =
@@ -0,0 +1,144 @@
+/*
+    SPDX-FileCopyrightText: Milian Wolff <milian.wolff@kdab.com>
+    SPDX-FileCopyrightText: 2016 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "sourcefilecache.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QLoggingCategory>
+
+#include <algorithm>
+#include <cstring>
+
+#include "disassemblyoutput.h"
+
+namespace {
+Q_LOGGING_CATEGORY(sourcefilecache, "hotspot.sourcefilecache", QtWarningMsg)
+}
+
+SourceFile::SourceFile(const QString& path)
+    : m_path(path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qCDebug(sourcefilecache) << "failed to open" << path << file.errorString();
+        m_size = -1;
+        return;
+    }
+
+    m_lastModified = file.fileTime(QFileDevice::FileModificationTime);
+    m_contents = file.readAll();
+    m_size = m_contents.size();
+
+    const auto* data = m_contents.constData();
+    m_lineStarts.push_back(0);
+    for (auto* it = data, *end = data + m_size; it != end;) {
+        const auto* newline = static_cast<const char*>(std::memchr(it, '\n', end - it));
+        if (!newline) {
+            break;
+        }
+        it = newline + 1;
+        m_lineStarts.push_back(it - data);
+    }
+}
+
+QString SourceFile::line(int index) const
+{
+    if (index < 0 || index >= lineCount()) {
+        return {};
+    }
+    return lineAt(index);
+}
+
+QString SourceFile::lineAt(int index) const
+{
+    const auto* data = m_contents.constData();
+    const auto start = m_lineStarts[index];
+    auto end = index + 1 < lineCount() ? m_lineStarts[index + 1] - 1 : m_size;
+    if (end > start && data[end - 1] == '\r') {
+        --end;
+    }
+    return QString::fromUtf8(data + start, end - start);
+}
+
+QStringList SourceFile::lines(int first, int count) const
+{
+    first = std::max(0, first);
+    const auto last = count < 0 ? lineCount() : std::min(lineCount(), first + count);
+
+    QStringList result;
+    result.reserve(std::max(0, last - first));
+    for (int i = first; i < last; ++i) {
+        result.append(lineAt(i));
+    }
+    return result;
+}
+
+SourceFileCache::SourceFileCache(int maxFiles)
+    : m_files(maxFiles)
+{
+}
+
+SourceFileCache* SourceFileCache::instance()
+{
+    static SourceFileCache cache;
+    return &cache;
+}
+
+QString SourceFileCache::resolve(const QString& originalPath, const QStringList& sourceCodePaths,
+                                 const QString& sysroot)
+{
+    const auto key = originalPath + QLatin1Char('\n') + sourceCodePaths.join(QLatin1Char('\n')) + QLatin1Char('\n')
+        + sysroot;
+    {
+        QMutexLocker lock(&m_mutex);
+        const auto it = m_resolvedPaths.constFind(key);
+        if (it != m_resolvedPaths.constEnd()) {
+            return *it;
+        }
+    }
+
+    // probe without holding the lock, in the worst case two threads do the same work
+    const auto path = findSourceCodeFile(originalPath, sourceCodePaths, sysroot);
+
+    QMutexLocker lock(&m_mutex);
+    m_resolvedPaths.insert(key, path);
+    return path;
+}
+
+std::shared_ptr<const SourceFile> SourceFileCache::file(const QString& path)
+{
+    const auto info = QFileInfo(path);
+    if (!info.exists()) {
+        return {};
+    }
+
+    {
+        QMutexLocker lock(&m_mutex);
+        if (const auto* file = m_files.object(path)) {
+            if ((*file)->lastModified() == info.lastModified() && (*file)->size() == info.size()) {
+                return *file;
+            }
+        }
+    }
+
+    auto file = std::make_shared<const SourceFile>(path);
+    if (!file->isValid()) {
+        return {};
+    }
+
+    QMutexLocker lock(&m_mutex);
+    m_files.insert(path, new std::shared_ptr<const SourceFile>(file));
+    return file;
+}
+
+void SourceFileCache::clear()
+{
+    QMutexLocker lock(&m_mutex);
+    m_resolvedPaths.clear();
+    m_files.clear();
+}
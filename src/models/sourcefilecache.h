@@ -0,0 +1,90 @@
+/*
+    SPDX-FileCopyrightText: Milian Wolff <milian.wolff@kdab.com>
+    SPDX-FileCopyrightText: 2016 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QByteArray>
+#include <QCache>
+#include <QDateTime>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+
+#include <memory>
+#include <vector>
+
+// a read-only source file with an index of where each line starts
+// lines are split on '\n' like QString::split would do, a trailing '\r' gets removed
+// the contents are read into memory, a mapping would crash with SIGBUS when a rebuild truncates the file
+class SourceFile
+{
+public:
+    explicit SourceFile(const QString& path);
+
+    bool isValid() const
+    {
+        return m_size >= 0;
+    }
+
+    QString path() const
+    {
+        return m_path;
+    }
+
+    QDateTime lastModified() const
+    {
+        return m_lastModified;
+    }
+
+    qint64 size() const
+    {
+        return m_size;
+    }
+
+    int lineCount() const
+    {
+        return static_cast<int>(m_lineStarts.size());
+    }
+
+    QString line(int index) const;
+    // returns up to @p count lines starting at @p first, pass -1 to get all remaining lines
+    QStringList lines(int first = 0, int count = -1) const;
+
+private:
+    QString lineAt(int index) const;
+
+    QString m_path;
+    QByteArray m_contents;
+    qint64 m_size = 0;
+    QDateTime m_lastModified;
+    std::vector<qint64> m_lineStarts;
+};
+
+// shares source files and the lookup of their location between the source view and the other pages
+// everything is guarded by a mutex, since the disassembly is created in a background thread
+class SourceFileCache
+{
+public:
+    // the cost of an entry is one per file
+    explicit SourceFileCache(int maxFiles = 64);
+
+    static SourceFileCache* instance();
+
+    // like findSourceCodeFile, but the result is cached, including the fallback when the file couldn't be found
+    QString resolve(const QString& originalPath, const QStringList& sourceCodePaths, const QString& sysroot);
+
+    // returns nullptr when the file cannot be opened, files that got modified on disk are loaded again
+    std::shared_ptr<const SourceFile> file(const QString& path);
+
+    void clear();
+
+private:
+    QMutex m_mutex;
+    QHash<QString, QString> m_resolvedPaths;
+    QCache<QString, std::shared_ptr<const SourceFile>> m_files;
+};
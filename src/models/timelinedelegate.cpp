@@ -8,6 +8,7 @@
 #include "timelinedelegate.h"
 
 #include <QAbstractItemView>
+#include <QCoreApplication>
 #include <QDebug>
 #include <QEvent>
 #include <QHelpEvent>
@@ -15,6 +16,8 @@
 #include <QPainter>
 #include <QToolTip>
 
+#include <ThreadWeaver/ThreadWeaver>
+
 #include "../util.h"
 #include "eventmodel.h"
 #include "filterandzoomstack.h"
@@ -132,43 +135,202 @@ Data::Events::const_iterator findEvent(Data::Events::const_iterator begin, Data:
     // if only one event is recorded, it will point to end it->time which will cause asan to complain
     return (it == begin || (it != end && it->time == time)) ? it : (it - 1);
 }
+
+bool containsStack(const QBitArray& stacks, qint32 stackId)
+{
+    return stackId >= 0 && stackId < stacks.size() && stacks.testBit(stackId);
+}
+
+QBitArray toBitArray(const QSet<qint32>& stacks)
+{
+    if (stacks.isEmpty())
+        return {};
+    QBitArray bits(*std::max_element(stacks.cbegin(), stacks.cend()) + 1);
+    for (auto stackId : stacks) {
+        if (stackId >= 0)
+            bits.setBit(stackId);
+    }
+    return bits;
+}
+
+bool isHighlighted(const EventPyramid::Mask& mask, int level, qsizetype bin)
+{
+    return level < mask.size() && mask[level].testBit(bin);
+}
+
+// calls @p callback with the time range and position of everything of the pyramid's type that is visible
+// when zoomed in far enough, the events are used directly and the level is -1, otherwise the index refers to a bin
+template<typename Callback>
+void forEachVisibleBin(const TimeLineData& data, const EventPyramid& pyramid, bool includePrevious,
+                       const Callback& callback)
+{
+    const auto type = pyramid.type();
+    const auto visibleTime = Data::TimeRange(data.mapXToTime(0), data.mapXToTime(data.w));
+    const auto level = pyramid.levelForResolution(1. / data.xMultiplicator);
+
+    if (level == -1) {
+        auto range = Data::findTimeRange(data.events, visibleTime);
+        if (includePrevious) {
+            for (auto it = range.first; it != data.events.cbegin();) {
+                --it;
+                if (it->type == type) {
+                    range.first = it;
+                    break;
+                }
+            }
+        }
+        for (auto it = range.first; it != range.second; ++it) {
+            if (it->type == type) {
+                callback(it->time, it->time + it->cost, level, std::distance(data.events.cbegin(), it));
+            }
+        }
+        return;
+    }
+
+    const auto& bins = pyramid.bins(level);
+    auto range = Data::findTimeRange(bins, visibleTime);
+    if (includePrevious && range.first != bins.cbegin()) {
+        --range.first;
+    }
+    for (auto it = range.first; it != range.second; ++it) {
+        callback(it->time, it->endTime, level, std::distance(bins.cbegin(), it));
+    }
+}
 }
 
 TimeLineDelegate::TimeLineDelegate(FilterAndZoomStack* filterAndZoomStack, QAbstractItemView* view, QObject* parent)
     : QStyledItemDelegate(parent)
     , m_filterAndZoomStack(filterAndZoomStack)
     , m_view(view)
+    , m_renderGeneration(std::make_shared<std::atomic<uint>>(0))
+    , m_maskGeneration(std::make_shared<std::atomic<uint>>(0))
 {
     m_view->viewport()->installEventFilter(this);
     m_view->viewport()->setAttribute(Qt::WA_Hover);
 
     connect(filterAndZoomStack, &FilterAndZoomStack::filterChanged, this, &TimeLineDelegate::updateView);
     connect(filterAndZoomStack, &FilterAndZoomStack::zoomChanged, this, &TimeLineDelegate::updateZoomState);
+    if (auto* model = m_view->model()) {
+        // the cached pyramids keep the events of the previous results alive
+        connect(model, &QAbstractItemModel::modelReset, this, [this]() {
+            m_pyramids.clear();
+            ++(*m_maskGeneration);
+            m_lastRowImages.clear();
+            ++m_dataGeneration;
+            invalidateRowImages();
+        });
+    }
+    // roughly the rows of a few screens full of threads
+    m_rowImages.setMaxCost(64 * 1024);
+    m_lastRowImages.setMaxCost(64 * 1024);
     updateColorScheme();
 }
 
-TimeLineDelegate::~TimeLineDelegate() = default;
+TimeLineDelegate::~TimeLineDelegate()
+{
+    // the queued results of the running jobs must not access this delegate anymore
+    ++(*m_renderGeneration);
+    ++(*m_maskGeneration);
+}
+
+const TimeLineDelegate::CachedPyramid* TimeLineDelegate::cachedPyramid(const Data::Events& events, qint32 type) const
+{
+    // the pyramids are only built by the render jobs, building them here would block the GUI thread
+    const auto it = m_pyramids.find(qMakePair(events.constData(), type));
+    if (it == m_pyramids.end() || !it->events.isSharedWith(events)) {
+        return nullptr;
+    }
 
-void TimeLineDelegate::paint(QPainter* painter, const QStyleOptionViewItem& option, const QModelIndex& index) const
+    auto& cached = *it;
+    // nothing to compute when nothing is highlighted
+    if (cached.selectedGeneration != m_selectedGeneration && m_selectedStacks.isEmpty()) {
+        cached.selected = {};
+        cached.selectedGeneration = m_selectedGeneration;
+    }
+    if (cached.hoveredGeneration != m_hoveredGeneration && m_hoveredStacks.isEmpty()) {
+        cached.hovered = {};
+        cached.hoveredGeneration = m_hoveredGeneration;
+    }
+    if (!cached.computingMasks
+        && (cached.selectedGeneration != m_selectedGeneration || cached.hoveredGeneration != m_hoveredGeneration)) {
+        scheduleMasks(cached);
+    }
+    return &cached;
+}
+
+void TimeLineDelegate::scheduleMasks(CachedPyramid& cached) const
 {
-    const auto data = dataFromIndex(index, option.rect, m_filterAndZoomStack->zoom());
-    const auto results = index.data(EventModel::EventResultsRole).value<Data::EventResults>();
-    const auto offCpuCostId = results.offCpuTimeCostId;
-    const auto lostEventCostId = results.lostEventCostId;
-    const bool is_alternate = option.features & QStyleOptionViewItem::Alternate;
-    const auto& palette = option.palette;
+    cached.computingMasks = true;
+
+    // only compute what is outdated, the masks depend on all events of the row
+    const auto selectedGeneration = m_selectedGeneration;
+    const auto hoveredGeneration = m_hoveredGeneration;
+    const auto selectedStacks = cached.selectedGeneration != selectedGeneration ? m_selectedStacks : QBitArray();
+    const auto hoveredStacks = cached.hoveredGeneration != hoveredGeneration ? m_hoveredStacks : QBitArray();
+
+    // like for the render jobs, the delegate is only touched in the GUI thread after checking the generation
+    const auto generation = m_maskGeneration->load();
+    auto isCancelled = [generation, currentGeneration = m_maskGeneration]() {
+        return generation != currentGeneration->load();
+    };
+
+    using namespace ThreadWeaver;
+    stream() << make_job([self = this, events = cached.events, pyramid = cached.pyramid, selectedStacks,
+                          hoveredStacks, selectedGeneration, hoveredGeneration, isCancelled]() {
+        auto mask = [&](const QBitArray& stacks) {
+            if (stacks.isEmpty() || isCancelled())
+                return EventPyramid::Mask();
+            return pyramid.highlightMask(events, [&stacks](qint32 stackId) { return containsStack(stacks, stackId); });
+        };
+        auto selected = mask(selectedStacks);
+        auto hovered = mask(hoveredStacks);
+        if (isCancelled())
+            return;
+
+        QMetaObject::invokeMethod(
+            QCoreApplication::instance(),
+            [self, events, type = pyramid.type(), updateSelected = !selectedStacks.isEmpty(),
+             updateHovered = !hoveredStacks.isEmpty(), selected = std::move(selected), hovered = std::move(hovered),
+             selectedGeneration, hoveredGeneration, isCancelled]() {
+                if (isCancelled())
+                    return;
+
+                const auto it = self->m_pyramids.find(qMakePair(events.constData(), type));
+                if (it == self->m_pyramids.end() || !it->events.isSharedWith(events))
+                    return;
+
+                it->computingMasks = false;
+                // the mask may have been cleared in the meantime, which must not be undone
+                if (updateSelected && it->selectedGeneration != self->m_selectedGeneration) {
+                    it->selected = selected;
+                    it->selectedGeneration = selectedGeneration;
+                }
+                if (updateHovered && it->hoveredGeneration != self->m_hoveredGeneration) {
+                    it->hovered = hovered;
+                    it->hoveredGeneration = hoveredGeneration;
+                }
+                self->m_view->viewport()->update();
+            },
+            Qt::QueuedConnection);
+    });
+}
 
-    painter->save();
+QImage TimeLineDelegate::renderRow(const TimeLineData& data, QSize size, qreal devicePixelRatio, const RowStyle& style,
+                                   const EventPyramid& events, const EventPyramid& offCpuEvents,
+                                   const EventPyramid& lostEvents)
+{
+    QImage image(size * devicePixelRatio, QImage::Format_ARGB32_Premultiplied);
+    image.setDevicePixelRatio(devicePixelRatio);
+
+    QPainter painter(&image);
     // disable antialiasing, we are only drawing straight boxes and lines
-    painter->setRenderHint(QPainter::Antialiasing, false);
+    painter.setRenderHint(QPainter::Antialiasing, false);
 
     // background
-    painter->fillRect(option.rect, is_alternate ? palette.base() : palette.alternateBase());
+    painter.fillRect(QRect(QPoint(0, 0), size), style.background);
 
-    // transform into target coordinate system
-    painter->translate(option.rect.topLeft());
     // account for padding
-    painter->translate(TimeLineData::padding, TimeLineData::padding);
+    painter.translate(TimeLineData::padding, TimeLineData::padding);
 
     // skip threads that are outside the visible (zoomed) region
 
@@ -176,84 +338,247 @@ void TimeLineDelegate::paint(QPainter* painter, const QStyleOptionViewItem& opti
     // i.e. paint events for threads that have any in the selected time range
     auto threadTimeRect =
         QRect(QPoint(data.mapTimeToX(data.threadTime.start), 0), QPoint(data.mapTimeToX(data.threadTime.end), data.h));
-    if (threadTimeRect.left() < option.rect.width() && threadTimeRect.right() > 0) {
-        if (threadTimeRect.left() < 0)
-            threadTimeRect.setLeft(0);
-        if (threadTimeRect.right() > option.rect.width())
-            threadTimeRect.setRight(option.rect.width());
-
-        auto runningColor = m_colorScheme.background(KColorScheme::PositiveBackground).color();
-        runningColor.setAlpha(128);
-        auto runningOutlineColor = m_colorScheme.foreground(KColorScheme::PositiveText).color();
-        runningOutlineColor.setAlpha(128);
-        painter->setBrush(QBrush(runningColor));
-        painter->setPen(QPen(runningOutlineColor, 1));
-        painter->drawRect(threadTimeRect.adjusted(-1, -1, 0, 0));
-
-        // visualize all events
-        painter->setBrush(QBrush());
-
-        if (offCpuCostId != -1) {
-            const auto offCpuColor = m_colorScheme.background(KColorScheme::NegativeBackground).color();
-            const auto offCpuColorSelected = m_colorScheme.foreground(KColorScheme::NegativeText).color();
-            const auto offCpuColorHovered = toHoverColor(offCpuColorSelected);
-            for (const auto& event : data.events) {
-                if (event.type != offCpuCostId) {
-                    continue;
-                }
+    if (threadTimeRect.left() >= size.width() || threadTimeRect.right() <= 0) {
+        return image;
+    }
+
+    if (threadTimeRect.left() < 0)
+        threadTimeRect.setLeft(0);
+    if (threadTimeRect.right() > size.width())
+        threadTimeRect.setRight(size.width());
+
+    painter.setBrush(QBrush(style.runningColor));
+    painter.setPen(QPen(style.runningOutlineColor, 1));
+    painter.drawRect(threadTimeRect.adjusted(-1, -1, 0, 0));
+
+    // visualize all events
+    painter.setBrush(QBrush());
+
+    if (offCpuEvents.type() != -1) {
+        // off-CPU events start before the sample that follows them, so include the one left of the visible area
+        forEachVisibleBin(data, offCpuEvents, true, [&](quint64 time, quint64 endTime, int, qsizetype) {
+            const auto x = data.mapTimeToX(time);
+            const auto x2 = data.mapTimeToX(endTime);
+            painter.fillRect(x, 0, x2 - x, data.h, style.offCpuColor);
+        });
+    }
 
-                const auto x = data.mapTimeToX(event.time);
-                const auto x2 = data.mapTimeToX(event.time + event.cost);
-                const auto& color = m_selectedStacks.contains(event.stackId)
-                    ? offCpuColorSelected
-                    : (m_hoveredStacks.contains(event.stackId) ? offCpuColorHovered : offCpuColor);
-                painter->fillRect(x, 0, x2 - x, data.h, color);
+    // TODO: accumulate cost for events that fall to the same pixel somehow
+    // but how to then sync the y scale across different delegates?
+    // somehow deduce threshold via min time delta and max cost?
+    // TODO: how to deal with broken cycle counts in frequency mode? For now,
+    // we simply always fill the complete height which is also what we'd get
+    // from a graph in count mode (perf record -F vs. perf record -c)
+    // see also: https://www.spinics.net/lists/linux-perf-users/msg03486.html
+    auto drawEvents = [&](const EventPyramid& pyramid, const QPen& pen) {
+        painter.setPen(pen);
+        // only draw a line when it changes anything visually
+        int lastX = -1;
+        forEachVisibleBin(data, pyramid, false, [&](quint64 time, quint64, int, qsizetype) {
+            const auto x = data.mapTimeToX(time);
+            if (x != lastX && x >= TimeLineData::padding && x < data.w) {
+                painter.drawLine(x, 0, x, data.h);
             }
+            lastX = x;
+        });
+    };
+    drawEvents(events, style.eventPen);
+    // lost events are drawn last, so that they are never hidden by samples
+    if (lostEvents.type() != -1) {
+        drawEvents(lostEvents, style.lostEventPen);
+    }
+
+    return image;
+}
+
+void TimeLineDelegate::scheduleRender(const RowImageKey& key, const LastRowImageKey& rowKey, const TimeLineData& data,
+                                      const RowStyle& style, qint32 offCpuCostId, qint32 lostEventCostId) const
+{
+    if (m_pendingRenders.contains(key)) {
+        return;
+    }
+    // the row key stays in the GUI thread, persistent indices must not be copied or destroyed in the render job
+    m_pendingRenders.insert(key, rowKey);
+
+    // reuse the pyramids we already know, the others get built by the job
+    auto knownPyramid = [this, &data](qint32 type) {
+        const auto it = m_pyramids.constFind(qMakePair(data.events.constData(), type));
+        return (it != m_pyramids.cend() && it->events.isSharedWith(data.events)) ? it->pyramid : EventPyramid();
+    };
+    const auto eventType = m_eventType;
+    // the lost events get drawn together with the samples when they are what the user looks at
+    if (lostEventCostId == eventType) {
+        lostEventCostId = -1;
+    }
+
+    // the job must not touch the delegate, only the result handler in the GUI thread may do so once it knows that
+    // the generation is still current, which also guarantees that the delegate has not been destroyed yet
+    const auto generation = m_renderGeneration->load();
+    auto isCancelled = [generation, currentGeneration = m_renderGeneration]() {
+        return generation != currentGeneration->load();
+    };
+
+    using namespace ThreadWeaver;
+    stream() << make_job([self = this, key, data, style, offCpuCostId, lostEventCostId, eventType, isCancelled,
+                          pyramids = QVector<EventPyramid> {knownPyramid(eventType), knownPyramid(offCpuCostId),
+                                                            knownPyramid(lostEventCostId)}]() mutable {
+        const qint32 types[] = {eventType, offCpuCostId, lostEventCostId};
+        for (int i = 0; i < pyramids.size(); ++i) {
+            if (isCancelled())
+                return;
+            if (types[i] != -1 && pyramids[i].type() != types[i])
+                pyramids[i] = EventPyramid(data.events, types[i]);
         }
+        if (isCancelled())
+            return;
+
+        auto image = renderRow(data, key.size, key.devicePixelRatio, style, pyramids[0], pyramids[1], pyramids[2]);
+
+        // the application object outlives the delegate, so it is always safe to queue the result there
+        QMetaObject::invokeMethod(
+            QCoreApplication::instance(),
+            [self, key, data, isCancelled, image = std::move(image), pyramids = std::move(pyramids)]() {
+                if (isCancelled())
+                    return;
+
+                const auto rowKey = self->m_pendingRenders.take(key);
+                const auto cost = image.sizeInBytes() / 1024;
+                self->m_rowImages.insert(key, new QImage(image), cost);
+                if (rowKey.row.isValid()) {
+                    self->m_lastRowImages.insert(rowKey, new QImage(image), cost);
+                }
+                for (const auto& pyramid : pyramids) {
+                    if (pyramid.type() == -1)
+                        continue;
+                    auto& cached = self->m_pyramids[qMakePair(data.events.constData(), pyramid.type())];
+                    if (!cached.events.isSharedWith(data.events)) {
+                        // the masks of other events don't fit the new bins
+                        cached = {};
+                        cached.events = data.events;
+                        cached.pyramid = pyramid;
+                    }
+                }
+                self->m_view->viewport()->update();
+            },
+            Qt::QueuedConnection);
+    });
+}
 
-        const auto selectedPen = QPen(m_colorScheme.foreground(KColorScheme::ActiveText), 1);
-        const auto hoveredPen = QPen(toHoverColor(selectedPen.color()), 1);
-        const auto eventPen = QPen(m_colorScheme.foreground(KColorScheme::NeutralText), 1);
-        const auto lostEventPen = QPen(m_colorScheme.foreground(KColorScheme::NegativeText), 1);
-
-        int last_x = -1;
-        // TODO: accumulate cost for events that fall to the same pixel somehow
-        // but how to then sync the y scale across different delegates?
-        // somehow deduce threshold via min time delta and max cost?
-        // TODO: how to deal with broken cycle counts in frequency mode? For now,
-        // we simply always fill the complete height which is also what we'd get
-        // from a graph in count mode (perf record -F vs. perf record -c)
-        // see also: https://www.spinics.net/lists/linux-perf-users/msg03486.html
-        for (const auto& event : data.events) {
-            const auto isLostEvent = event.type == lostEventCostId;
-            if (event.type != m_eventType && !isLostEvent) {
-                continue;
-            }
+void TimeLineDelegate::paintHighlights(QPainter* painter, const TimeLineData& data, qint32 offCpuCostId) const
+{
+    if (m_selectedStacks.isEmpty() && m_hoveredStacks.isEmpty()) {
+        return;
+    }
 
-            const auto x = data.mapTimeToX(event.time);
-            if (x < TimeLineData::padding || x >= data.w) {
-                continue;
-            }
+    // returns whether the event or bin is selected and whether it is hovered
+    auto highlights = [&](const CachedPyramid& cached, int level, qsizetype index) {
+        if (level == -1) {
+            const auto stackId = data.events[index].stackId;
+            return qMakePair(containsStack(m_selectedStacks, stackId), containsStack(m_hoveredStacks, stackId));
+        }
+        return qMakePair(isHighlighted(cached.selected, level, index), isHighlighted(cached.hovered, level, index));
+    };
+
+    if (offCpuCostId != -1) {
+        const auto offCpuColorSelected = m_colorScheme.foreground(KColorScheme::NegativeText).color();
+        const auto offCpuColorHovered = toHoverColor(offCpuColorSelected);
+        if (const auto* cached = cachedPyramid(data.events, offCpuCostId)) {
+            forEachVisibleBin(data, cached->pyramid, true,
+                              [&](quint64 time, quint64 endTime, int level, qsizetype index) {
+                                  const auto highlight = highlights(*cached, level, index);
+                                  if (!highlight.first && !highlight.second) {
+                                      return;
+                                  }
+                                  const auto x = data.mapTimeToX(time);
+                                  const auto x2 = data.mapTimeToX(endTime);
+                                  painter->fillRect(x, 0, x2 - x, data.h,
+                                                    highlight.first ? offCpuColorSelected : offCpuColorHovered);
+                              });
+        }
+    }
 
-            // only draw a line when it changes anything visually
-            // but always force drawing of lost events
-            if (x != last_x || isLostEvent) {
-                if (isLostEvent)
-                    painter->setPen(lostEventPen);
-                else if (m_selectedStacks.contains(event.stackId))
-                    painter->setPen(selectedPen);
-                else if (m_hoveredStacks.contains(event.stackId))
-                    painter->setPen(hoveredPen);
-                else
-                    painter->setPen(eventPen);
-
-                painter->drawLine(x, 0, x, data.h);
-            }
+    const auto* cached = cachedPyramid(data.events, m_eventType);
+    if (!cached) {
+        return;
+    }
 
-            last_x = x;
+    const auto selectedPen = QPen(m_colorScheme.foreground(KColorScheme::ActiveText), 1);
+    const auto hoveredPen = QPen(toHoverColor(selectedPen.color()), 1);
+
+    // only draw one line per pixel, highlighted when any of the events in it are
+    int lastX = -1;
+    bool anySelected = false;
+    bool anyHovered = false;
+    auto drawLastLine = [&]() {
+        if ((!anySelected && !anyHovered) || lastX < TimeLineData::padding || lastX >= data.w) {
+            return;
+        }
+        painter->setPen(anySelected ? selectedPen : hoveredPen);
+        painter->drawLine(lastX, 0, lastX, data.h);
+    };
+    forEachVisibleBin(data, cached->pyramid, false, [&](quint64 time, quint64, int level, qsizetype index) {
+        const auto x = data.mapTimeToX(time);
+        if (x != lastX) {
+            drawLastLine();
+            lastX = x;
+            anySelected = false;
+            anyHovered = false;
+        }
+        const auto highlight = highlights(*cached, level, index);
+        anySelected |= highlight.first;
+        anyHovered |= highlight.second;
+    });
+    drawLastLine();
+}
+
+void TimeLineDelegate::paint(QPainter* painter, const QStyleOptionViewItem& option, const QModelIndex& index) const
+{
+    const auto data = dataFromIndex(index, option.rect, m_filterAndZoomStack->zoom());
+    const auto results = index.data(EventModel::EventResultsRole).value<Data::EventResults>();
+    const auto offCpuCostId = results.offCpuTimeCostId;
+    const bool is_alternate = option.features & QStyleOptionViewItem::Alternate;
+    const auto& palette = option.palette;
+    const auto devicePixelRatio = painter->device()->devicePixelRatio();
+
+    // the rows get rendered without highlights in the background, those get painted on top as they change more often
+    const RowImageKey key = {data.events.constData(), m_eventType, data.time, data.threadTime, option.rect.size(),
+                             devicePixelRatio, is_alternate};
+    const auto* image = m_rowImages.object(key);
+    if (image) {
+        painter->drawImage(option.rect.topLeft(), *image);
+    } else {
+        RowStyle style;
+        style.background = is_alternate ? palette.base() : palette.alternateBase();
+        style.runningColor = m_colorScheme.background(KColorScheme::PositiveBackground).color();
+        style.runningColor.setAlpha(128);
+        style.runningOutlineColor = m_colorScheme.foreground(KColorScheme::PositiveText).color();
+        style.runningOutlineColor.setAlpha(128);
+        style.offCpuColor = m_colorScheme.background(KColorScheme::NegativeBackground).color();
+        style.eventPen = QPen(m_colorScheme.foreground(KColorScheme::NeutralText), 1);
+        style.lostEventPen = QPen(m_colorScheme.foreground(KColorScheme::NegativeText), 1);
+        const LastRowImageKey rowKey = {index, m_dataGeneration};
+        scheduleRender(key, rowKey, data, style, offCpuCostId, results.lostEventCostId);
+
+        // show the last image we got for this row until the new one is ready
+        if (const auto* lastImage = m_lastRowImages.object(rowKey)) {
+            painter->drawImage(option.rect, *lastImage);
+        } else {
+            painter->fillRect(option.rect, style.background);
         }
     }
 
+    painter->save();
+    // disable antialiasing, we are only drawing straight boxes and lines
+    painter->setRenderHint(QPainter::Antialiasing, false);
+
+    // transform into target coordinate system
+    painter->translate(option.rect.topLeft());
+    // account for padding
+    painter->translate(TimeLineData::padding, TimeLineData::padding);
+
+    // the highlights are painted on top, also of an outdated image, with the last masks until the new ones are ready
+    paintHighlights(painter, data, offCpuCostId);
+
     if (m_timeSlice.isValid()) {
         // the painter is translated to option.rect.topLeft
         // clamp to available width to prevent us from painting over the other columns
@@ -381,7 +706,6 @@ bool TimeLineDelegate::eventFilter(QObject* watched, QEvent* event)
 
     if (isHover) {
         QSet<qint32> stacks;
-        stacks.reserve(m_hoveredStacks.size());
         if (inEventsColumn && event->type() != QEvent::HoverLeave) {
             const auto results = alwaysValidIndex.data(EventModel::EventResultsRole).value<Data::EventResults>();
             const auto data = dataFromIndex(m_view->indexAt(pos.toPoint()), visualRect, zoom);
@@ -409,8 +733,10 @@ bool TimeLineDelegate::eventFilter(QObject* watched, QEvent* event)
             Q_UNUSED(found);
         }
 
-        if (stacks != m_hoveredStacks) {
-            m_hoveredStacks = stacks;
+        auto hoveredStacks = toBitArray(stacks);
+        if (hoveredStacks != m_hoveredStacks) {
+            m_hoveredStacks = std::move(hoveredStacks);
+            ++m_hoveredGeneration;
             emit stacksHovered(stacks);
             updateView();
         }
@@ -578,12 +904,14 @@ bool TimeLineDelegate::eventFilter(QObject* watched, QEvent* event)
 void TimeLineDelegate::setEventType(int type)
 {
     m_eventType = type;
+    invalidateRowImages();
     updateView();
 }
 
-void TimeLineDelegate::setSelectedStacks(const QSet<qint32>& selectedStacks)
+void TimeLineDelegate::setSelectedStacks(const QBitArray& selectedStacks)
 {
     m_selectedStacks = selectedStacks;
+    ++m_selectedGeneration;
     updateView();
 }
 
@@ -595,10 +923,20 @@ void TimeLineDelegate::updateView()
 void TimeLineDelegate::updateZoomState()
 {
     m_timeSlice = {};
+    invalidateRowImages();
     updateView();
 }
 
+void TimeLineDelegate::invalidateRowImages()
+{
+    // this also cancels all render jobs that are still running
+    ++(*m_renderGeneration);
+    m_rowImages.clear();
+    m_pendingRenders.clear();
+}
+
 void TimeLineDelegate::updateColorScheme()
 {
     m_colorScheme = KColorScheme(QPalette::ColorGroup::Inactive);
+    invalidateRowImages();
 }
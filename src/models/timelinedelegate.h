@@ -7,12 +7,22 @@
 
 #pragma once
 
+#include <QBitArray>
+#include <QCache>
+#include <QHash>
+#include <QImage>
+#include <QPen>
+#include <QPersistentModelIndex>
 #include <QSet>
 #include <QStyledItemDelegate>
 
 #include <KColorScheme>
 
 #include "data.h"
+#include "eventpyramid.h"
+
+#include <atomic>
+#include <memory>
 
 class QAbstractItemView;
 class QAction;
@@ -62,7 +72,8 @@ public:
                    const QModelIndex& index) override;
 
     void setEventType(int type);
-    void setSelectedStacks(const QSet<qint32>& selectedStacks);
+    // one bit per stack id, set for the stacks that should be highlighted
+    void setSelectedStacks(const QBitArray& selectedStacks);
 
 signals:
     void stacksHovered(const QSet<qint32>& stacks);
@@ -74,12 +85,108 @@ private:
     void updateColorScheme();
     void updateView();
     void updateZoomState();
+    void invalidateRowImages();
+
+    struct CachedPyramid
+    {
+        // keeps the events alive, which guarantees that no other row can reuse the same key
+        Data::Events events;
+        EventPyramid pyramid;
+        // the generations of the stacks the masks were computed for, outdated masks get painted until the new ones
+        // are ready
+        uint selectedGeneration = 0;
+        uint hoveredGeneration = 0;
+        EventPyramid::Mask selected;
+        EventPyramid::Mask hovered;
+        // only one mask job runs per pyramid, changes in the meantime are picked up by the next paint
+        bool computingMasks = false;
+    };
+    // returns nullptr while the render job still builds the pyramid, schedules a mask job when the masks are outdated
+    const CachedPyramid* cachedPyramid(const Data::Events& events, qint32 type) const;
+    void scheduleMasks(CachedPyramid& cached) const;
+    void paintHighlights(QPainter* painter, const TimeLineData& data, qint32 offCpuCostId) const;
+
+    // everything a render job needs to know about the colors, as the color scheme must not be used off the GUI thread
+    struct RowStyle
+    {
+        QBrush background;
+        QColor runningColor;
+        QColor runningOutlineColor;
+        QColor offCpuColor;
+        QPen eventPen;
+        QPen lostEventPen;
+    };
+    static QImage renderRow(const TimeLineData& data, QSize size, qreal devicePixelRatio, const RowStyle& style,
+                            const EventPyramid& events, const EventPyramid& offCpuEvents,
+                            const EventPyramid& lostEvents);
+
+    struct RowImageKey
+    {
+        const Data::Event* events;
+        qint32 eventType;
+        Data::TimeRange time;
+        Data::TimeRange threadTime;
+        QSize size;
+        qreal devicePixelRatio;
+        bool isAlternate;
+
+        bool operator==(const RowImageKey& rhs) const
+        {
+            return std::tie(events, eventType, time, threadTime, size, devicePixelRatio, isAlternate)
+                == std::tie(rhs.events, rhs.eventType, rhs.time, rhs.threadTime, rhs.size, rhs.devicePixelRatio,
+                            rhs.isAlternate);
+        }
+
+        friend size_t qHash(const RowImageKey& key, size_t seed = 0)
+        {
+            return qHashMulti(seed, key.events, key.eventType, key.time.start, key.time.end, key.threadTime.start,
+                              key.threadTime.end, key.size.width(), key.size.height(), key.devicePixelRatio,
+                              key.isAlternate);
+        }
+    };
+
+    // identifies a row independent of its events, the persistent index follows the row when it gets moved
+    struct LastRowImageKey
+    {
+        QPersistentModelIndex row;
+        uint dataGeneration;
+
+        bool operator==(const LastRowImageKey& rhs) const
+        {
+            return row == rhs.row && dataGeneration == rhs.dataGeneration;
+        }
+
+        friend size_t qHash(const LastRowImageKey& key, size_t seed = 0)
+        {
+            return qHashMulti(seed, key.row, key.dataGeneration);
+        }
+    };
+    void scheduleRender(const RowImageKey& key, const LastRowImageKey& rowKey, const TimeLineData& data,
+                        const RowStyle& style, qint32 offCpuCostId, qint32 lostEventCostId) const;
 
     FilterAndZoomStack* m_filterAndZoomStack = nullptr;
     QAbstractItemView* m_view = nullptr;
     KColorScheme m_colorScheme;
     Data::TimeRange m_timeSlice;
-    QSet<qint32> m_selectedStacks;
-    QSet<qint32> m_hoveredStacks;
+    QBitArray m_selectedStacks;
+    QBitArray m_hoveredStacks;
     int m_eventType = 0;
+    // bumped whenever the selected or hovered stacks change, to invalidate the respective cached highlight masks
+    // separate, since hovering changes far more often than the selection
+    uint m_selectedGeneration = 1;
+    uint m_hoveredGeneration = 1;
+    mutable QHash<QPair<const Data::Event*, qint32>, CachedPyramid> m_pyramids;
+    // rendered rows without highlights, the cost is the size in KiB
+    mutable QCache<RowImageKey, QImage> m_rowImages;
+    // the last image rendered for a row, shown until an up to date image is ready
+    mutable QCache<LastRowImageKey, QImage> m_lastRowImages;
+    // bumped when the model gets reset, so that no row shows an image of the previous data
+    uint m_dataGeneration = 0;
+    // the rows that are waiting for a render job
+    mutable QHash<RowImageKey, LastRowImageKey> m_pendingRenders;
+    // bumped to discard the row images and cancel the outdated render jobs, also when the delegate gets destroyed
+    // shared with the jobs, as they may outlive the delegate
+    std::shared_ptr<std::atomic<uint>> m_renderGeneration;
+    // bumped when the cached pyramids get discarded, to drop the results of the outdated mask jobs
+    std::shared_ptr<std::atomic<uint>> m_maskGeneration;
 };
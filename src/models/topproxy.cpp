@@ -9,6 +9,10 @@
 
 #include "treemodel.h"
 
+namespace {
+const int numTopRows = 5;
+}
+
 TopProxy::TopProxy(QObject* parent)
     : QSortFilterProxyModel(parent)
     , m_costColumn(BottomUpModel::InitialSortColumn)
@@ -16,6 +20,14 @@ TopProxy::TopProxy(QObject* parent)
 {
     sort(m_costColumn, Qt::DescendingOrder);
     setSortRole(AbstractTreeModel::SortRole);
+
+    connect(this, &QAbstractProxyModel::sourceModelChanged, this, [this]() {
+        disconnect(m_sourceResetConnection);
+        if (auto* model = sourceModel()) {
+            m_sourceResetConnection = connect(model, &QAbstractItemModel::modelReset, this, &TopProxy::updateTopRows);
+        }
+        updateTopRows();
+    });
 }
 
 TopProxy::~TopProxy() = default;
@@ -23,7 +35,7 @@ TopProxy::~TopProxy() = default;
 void TopProxy::setCostColumn(int costColumn)
 {
     m_costColumn = costColumn;
-    invalidate();
+    updateTopRows();
     sort(m_costColumn, Qt::DescendingOrder);
 }
 
@@ -38,12 +50,12 @@ int TopProxy::rowCount(const QModelIndex& parent) const
     if (parent.isValid() || !sourceModel()) {
         return 0; // this is not a tree
     }
-    return std::min(5, QSortFilterProxyModel::rowCount(parent));
+    return std::min(numTopRows, QSortFilterProxyModel::rowCount(parent));
 }
 
 bool TopProxy::filterAcceptsRow(int source_row, const QModelIndex& source_parent) const
 {
-    if (source_parent.isValid()) {
+    if (source_parent.isValid() || !m_topRows.contains(source_row)) {
         return false;
     }
     if (!sourceModel()->index(source_row, m_costColumn, source_parent).data(sortRole()).value<quint64>()) {
@@ -52,6 +64,14 @@ bool TopProxy::filterAcceptsRow(int source_row, const QModelIndex& source_parent
     return true;
 }
 
+void TopProxy::updateTopRows()
+{
+    const auto* model = qobject_cast<const AbstractTreeModel*>(sourceModel());
+    Q_ASSERT(!sourceModel() || model);
+    m_topRows = model && m_costColumn < model->columnCount() ? model->topRows(m_costColumn, numTopRows) : QVector<int>();
+    invalidate();
+}
+
 bool TopProxy::filterAcceptsColumn(int source_column, const QModelIndex& /*source_parent*/) const
 {
     return source_column < m_numBaseColumns || source_column == m_costColumn;
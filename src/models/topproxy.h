@@ -27,6 +27,11 @@ protected:
     bool filterAcceptsColumn(int source_column, const QModelIndex& source_parent) const override;
 
 private:
+    void updateTopRows();
+
     int m_costColumn; // NOLINT(modernize-use-default-member-init)
     int m_numBaseColumns; // NOLINT(modernize-use-default-member-init)
+    // the source rows that get shown, found without sorting the whole source model
+    QVector<int> m_topRows;
+    QMetaObject::Connection m_sourceResetConnection;
 };
@@ -85,6 +85,11 @@ QVariant BottomUpModel::rowData(const Data::BottomUp* row, int column, int role)
     }
 }
 
+qint64 BottomUpModel::rowCost(const Data::BottomUp* row, int column) const
+{
+    return m_results.costs.cost(column - NUM_BASE_COLUMNS, row->id);
+}
+
 int BottomUpModel::numColumns() const
 {
     return NUM_BASE_COLUMNS + m_results.costs.numTypes();
@@ -194,6 +199,17 @@ QVariant TopDownModel::rowData(const Data::TopDown* row, int column, int role) c
     }
 }
 
+qint64 TopDownModel::rowCost(const Data::TopDown* row, int column) const
+{
+    column -= NUM_BASE_COLUMNS;
+    if (column < m_results.inclusiveCosts.numTypes()) {
+        return m_results.inclusiveCosts.cost(column, row->id);
+    }
+
+    column -= m_results.inclusiveCosts.numTypes();
+    return m_results.selfCosts.cost(column, row->id);
+}
+
 int TopDownModel::numColumns() const
 {
     return NUM_BASE_COLUMNS + m_results.selfCosts.numTypes() + m_results.inclusiveCosts.numTypes();
@@ -261,6 +277,11 @@ QVariant PerLibraryModel::rowData(const Data::PerLibrary* row, int column, int r
     }
 }
 
+qint64 PerLibraryModel::rowCost(const Data::PerLibrary* row, int column) const
+{
+    return m_results.costs.cost(column - NUM_BASE_COLUMNS, row->id);
+}
+
 int PerLibraryModel::numColumns() const
 {
     return NUM_BASE_COLUMNS + m_results.costs.numTypes();
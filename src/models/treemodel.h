@@ -8,9 +8,16 @@
 #pragma once
 
 #include <QAbstractItemModel>
+#include <QHash>
+#include <QtConcurrent/QtConcurrentMap>
 
 #include "data.h"
 
+#include <algorithm>
+#include <memory>
+#include <numeric>
+#include <unordered_map>
+
 class AbstractTreeModel : public QAbstractItemModel
 {
     Q_OBJECT
@@ -24,6 +31,13 @@ public:
         TotalCostRole,
         SymbolRole
     };
+
+    // huge nodes expose their children in batches via fetchMore, while set all of them are exposed at once
+    // unsetting it only affects data that is set afterwards, rows that got exposed already stay
+    virtual void setFetchAll(bool fetchAll) = 0;
+
+    // returns the top level rows with the highest costs in @p column, the most expensive first
+    virtual QVector<int> topRows(int column, int numRows) const = 0;
 };
 
 template<typename TreeNode_t, class ModelImpl>
@@ -55,6 +69,9 @@ public:
             return 0;
         } else if (auto item = itemFromIndex(parent)) {
             if (!m_simplify || item == rootItem() || item->children.size() != 1) {
+                if (const auto* sorted = sortedChildren(item)) {
+                    return sorted->numFetched;
+                }
                 return item->children.size();
             } else if (item->parent && item->parent->children.size() == 1) {
                 // simplified
@@ -62,18 +79,98 @@ public:
             }
 
             // aggregate all simplified nodes
-            int numChildren = 1;
-            item = item->children.constData();
-            while (item->children.size() == 1) {
-                numChildren++;
-                item = item->children.constData();
-            }
-            return numChildren;
+            return simplifiedChain(item).size();
         }
 
         return 0;
     }
 
+    bool canFetchMore(const QModelIndex& parent) const final
+    {
+        if (parent.column() >= 1) {
+            return false;
+        }
+        const auto* item = itemFromIndex(parent);
+        if (!item) {
+            return false;
+        }
+        const auto* sorted = sortedChildren(item);
+        return sorted && sorted->numFetched < item->children.size();
+    }
+
+    void fetchMore(const QModelIndex& parent) final
+    {
+        if (!canFetchMore(parent)) {
+            return;
+        }
+        const auto* item = itemFromIndex(parent);
+        auto* sorted = sortedChildren(item);
+        const auto first = sorted->numFetched;
+        const auto last = std::min(first + fetchBatchSize, static_cast<int>(item->children.size())) - 1;
+        beginInsertRows(parent.isValid() ? parent.siblingAtColumn(0) : parent, first, last);
+        sorted->numFetched = last + 1;
+        endInsertRows();
+    }
+
+    void setFetchAll(bool fetchAll) final
+    {
+        // nodes of data that gets set from now on are fetched completely right away
+        m_fetchAll = fetchAll;
+        if (!fetchAll) {
+            return;
+        }
+        for (const auto& [item, sorted] : m_sortedChildren) {
+            const int numChildren = item->children.size();
+            if (sorted->numFetched == numChildren) {
+                continue;
+            }
+            beginInsertRows(item == rootItem() ? QModelIndex() : indexFromItem(item, 0), sorted->numFetched,
+                            numChildren - 1);
+            sorted->numFetched = numChildren;
+            endInsertRows();
+        }
+    }
+
+    QVector<int> topRows(int column, int numRows) const final
+    {
+        const auto* root = rootItem();
+        const int numChildren = root->children.size();
+        numRows = std::min(numRows, numChildren);
+
+        // no need to sort everything just to find a few rows
+        QVector<int> children(numChildren);
+        std::iota(children.begin(), children.end(), 0);
+        std::partial_sort(children.begin(), children.begin() + numRows, children.end(), [&](int lhs, int rhs) {
+            return rowCost(root->children.constData() + lhs, column)
+                > rowCost(root->children.constData() + rhs, column);
+        });
+        children.resize(numRows);
+
+        if (const auto* sorted = sortedChildren(root)) {
+            for (auto& row : children) {
+                row = sorted->rows[row];
+            }
+        }
+        return children;
+    }
+
+    // compares the costs of two siblings without going through QVariant, for fast sorting by cost columns
+    bool costLessThan(const QModelIndex& lhs, const QModelIndex& rhs) const
+    {
+        Q_ASSERT(lhs.column() == rhs.column() && lhs.column() >= ModelImpl::NUM_BASE_COLUMNS);
+        Q_ASSERT(lhs.internalPointer() == rhs.internalPointer());
+        const auto* lhsItem = itemFromIndex(lhs);
+        const auto* rhsItem = itemFromIndex(rhs);
+        const auto* parent = reinterpret_cast<const TreeNode*>(lhs.internalPointer());
+        if (const auto* sorted = sortedChildren(parent)) {
+            // higher ranks mean lower costs
+            const auto& ranks = sorted->costRanks[lhs.column() - ModelImpl::NUM_BASE_COLUMNS];
+            const auto* children = parent->children.constData();
+            return ranks[std::distance(children, lhsItem)] > ranks[std::distance(children, rhsItem)];
+        }
+        return rowCost(lhsItem, lhs.column()) < rowCost(rhsItem, rhs.column());
+    }
+
     int columnCount(const QModelIndex& parent = {}) const final
     {
         if (!parent.isValid() || parent.column() == 0) {
@@ -106,9 +203,7 @@ public:
         }
         auto* parent = childItem->parent;
         if (m_simplify && parent && parent->children.size() == 1) {
-            while (parent->parent && parent->parent->children.size() == 1) {
-                parent = parent->parent;
-            }
+            parent = chainPosition(childItem).head;
         }
 
         return indexFromItem(parent, 0);
@@ -158,6 +253,7 @@ public:
     {
         beginResetModel();
         m_simplify = simplify;
+        clearChains();
         endResetModel();
     }
 
@@ -167,25 +263,36 @@ public:
             return rootItem();
         } else {
             auto parent = reinterpret_cast<const TreeNode*>(index.internalPointer());
-            if (m_simplify && parent->children.size() == 1) {
-                int row = index.row();
-                auto item = parent->children.constData();
-                while (row) {
-                    Q_ASSERT(item->children.size() == 1);
-                    item = item->children.constData();
-                    --row;
-                }
-                Q_ASSERT(!row);
-                return item;
+            if (m_simplify && parent != rootItem() && parent->children.size() == 1) {
+                const auto& chain = simplifiedChain(parent);
+                Q_ASSERT(index.row() < chain.size());
+                return chain.value(index.row());
             }
             if (index.row() >= parent->children.size()) {
                 return nullptr;
             }
+            if (const auto* sorted = sortedChildren(parent)) {
+                return parent->children.constData() + sorted->order[index.row()];
+            }
             return parent->children.constData() + index.row();
         }
     }
 
+protected:
+    // must be called whenever the tree changes, before the rows get exposed
+    void updateCaches()
+    {
+        clearChains();
+        sortHugeNodes();
+    }
+
 private:
+    void clearChains()
+    {
+        m_chains.clear();
+        m_chainPositions.clear();
+    }
+
     QModelIndex indexFromItem(const TreeNode* item, int column) const
     {
         if (!item || column < 0 || column >= numColumns()) {
@@ -199,27 +306,176 @@ private:
         Q_ASSERT(parentItem->children.constData() <= item);
         Q_ASSERT(parentItem->children.constData() + parentItem->children.size() > item);
 
-        int row = 0;
-        if (m_simplify && parentItem->children.size() == 1) {
-            while (parentItem->parent && parentItem->parent->children.size() == 1) {
-                ++row;
-                parentItem = parentItem->parent;
-            };
-            Q_ASSERT(parentItem->children.size() == 1);
-        } else {
-            row = std::distance(parentItem->children.constData(), item);
+        if (m_simplify && parentItem != rootItem() && parentItem->children.size() == 1) {
+            const auto position = chainPosition(item);
+            return createIndex(position.row, column, const_cast<TreeNode*>(position.head));
         }
 
+        int row = std::distance(parentItem->children.constData(), item);
+        if (const auto* sorted = sortedChildren(parentItem)) {
+            row = sorted->rows[row];
+        }
         return createIndex(row, column, const_cast<TreeNode*>(parentItem));
     }
 
+    // the nodes that get aggregated as rows of @p head when simplifying, i.e. its only child followed by all
+    // descendants up to and including the first node that doesn't have exactly one child
+    const QVector<const TreeNode*>& simplifiedChain(const TreeNode* head) const
+    {
+        auto it = m_chains.find(head);
+        if (it == m_chains.end()) {
+            QVector<const TreeNode*> chain;
+            const auto* item = head;
+            do {
+                item = item->children.constData();
+                m_chainPositions.insert(item, {head, static_cast<int>(chain.size())});
+                chain.append(item);
+            } while (item->children.size() == 1);
+            it = m_chains.insert(head, chain);
+        }
+        return *it;
+    }
+
+    struct ChainPosition
+    {
+        const TreeNode* head = nullptr;
+        int row = 0;
+    };
+
+    // @p item must be part of a simplified chain, i.e. its parent has exactly one child
+    ChainPosition chainPosition(const TreeNode* item) const
+    {
+        auto it = m_chainPositions.constFind(item);
+        if (it != m_chainPositions.constEnd()) {
+            return *it;
+        }
+
+        const auto* head = item->parent;
+        while (head->parent && head->parent->children.size() == 1) {
+            head = head->parent;
+        }
+        simplifiedChain(head);
+        Q_ASSERT(m_chainPositions.contains(item));
+        return m_chainPositions.value(item);
+    }
+
+    struct SortedChildren
+    {
+        // the child indices in the order they are shown, i.e. the most expensive first
+        QVector<int> order;
+        // the inverse of order, mapping child indices to rows
+        QVector<int> rows;
+        // for every cost column, maps child indices to their position when sorted by that column
+        QVector<QVector<int>> costRanks;
+        int numFetched = 0;
+    };
+
+    // only nodes with many children get fetched in batches, all other nodes show their children as they are
+    SortedChildren* sortedChildren(const TreeNode* item) const
+    {
+        if (item->children.size() <= fetchBatchSize) {
+            return nullptr;
+        }
+        const auto it = m_sortedChildren.find(item);
+        return it == m_sortedChildren.end() ? nullptr : it->second.get();
+    }
+
+    static void findHugeNodes(const TreeNode* item, QVector<const TreeNode*>* hugeNodes)
+    {
+        if (item->children.size() > fetchBatchSize) {
+            hugeNodes->append(item);
+        }
+        for (const auto& child : item->children) {
+            findHugeNodes(&child, hugeNodes);
+        }
+    }
+
+    // sorts the children of all nodes that get fetched in batches, the cost columns of all nodes get sorted in parallel
+    void sortHugeNodes()
+    {
+        m_sortedChildren.clear();
+
+        QVector<const TreeNode*> hugeNodes;
+        findHugeNodes(rootItem(), &hugeNodes);
+        if (hugeNodes.isEmpty()) {
+            return;
+        }
+
+        const int numCostColumns = numColumns() - ModelImpl::NUM_BASE_COLUMNS;
+        QVector<QPair<const TreeNode*, int>> columns;
+        columns.reserve(hugeNodes.size() * numCostColumns);
+        for (const auto* item : std::as_const(hugeNodes)) {
+            for (int column = ModelImpl::NUM_BASE_COLUMNS; column < numColumns(); ++column) {
+                columns.append({item, column});
+            }
+        }
+        const auto costRanksPerColumn = QtConcurrent::blockingMapped<QVector<QVector<int>>>(
+            columns,
+            [this](const QPair<const TreeNode*, int>& column) { return costRanks(column.first, column.second); });
+
+        for (int i = 0; i < hugeNodes.size(); ++i) {
+            const auto* item = hugeNodes[i];
+            const int numChildren = item->children.size();
+            auto sorted = std::make_unique<SortedChildren>();
+            sorted->costRanks = costRanksPerColumn.mid(i * numCostColumns, numCostColumns);
+
+            // rank the children by their best position in any cost column, such that every batch includes
+            // the most expensive remaining children for each of the columns
+            QVector<int> bestRank(numChildren, numChildren);
+            for (const auto& ranks : std::as_const(sorted->costRanks)) {
+                for (int j = 0; j < numChildren; ++j) {
+                    bestRank[j] = std::min(bestRank[j], ranks[j]);
+                }
+            }
+            sorted->order.resize(numChildren);
+            std::iota(sorted->order.begin(), sorted->order.end(), 0);
+            std::stable_sort(sorted->order.begin(), sorted->order.end(),
+                             [&bestRank](int lhs, int rhs) { return bestRank[lhs] < bestRank[rhs]; });
+
+            sorted->rows.resize(numChildren);
+            for (int row = 0; row < numChildren; ++row) {
+                sorted->rows[sorted->order[row]] = row;
+            }
+            sorted->numFetched = m_fetchAll ? numChildren : fetchBatchSize;
+            m_sortedChildren[item] = std::move(sorted);
+        }
+    }
+
+    // maps the children of @p item to their position when sorted by @p column, the most expensive one comes first
+    QVector<int> costRanks(const TreeNode* item, int column) const
+    {
+        const int numChildren = item->children.size();
+        QVector<int> byCost(numChildren);
+        std::iota(byCost.begin(), byCost.end(), 0);
+        std::stable_sort(byCost.begin(), byCost.end(), [&](int lhs, int rhs) {
+            return rowCost(item->children.constData() + lhs, column) > rowCost(item->children.constData() + rhs, column);
+        });
+
+        QVector<int> ranks(numChildren);
+        for (int rank = 0; rank < numChildren; ++rank) {
+            ranks[byCost[rank]] = rank;
+        }
+        return ranks;
+    }
+
     virtual const TreeNode* rootItem() const = 0;
     virtual int numColumns() const = 0;
     virtual QVariant headerColumnData(int column, int role) const = 0;
     virtual QVariant rowData(const TreeNode* item, int column, int role) const = 0;
+    // the cost shown in @p column, which must not be one of the base columns
+    virtual qint64 rowCost(const TreeNode* item, int column) const = 0;
+
+    static constexpr int fetchBatchSize = 1000;
 
     quint64 m_sampleCount = 0;
     bool m_simplify = true;
+    // the chains are computed on demand, such that huge trees only pay for what is shown
+    mutable QHash<const TreeNode*, QVector<const TreeNode*>> m_chains;
+    mutable QHash<const TreeNode*, ChainPosition> m_chainPositions;
+    // computed whenever the tree changes, the pointers stay valid until then
+    std::unordered_map<const TreeNode*, std::unique_ptr<SortedChildren>> m_sortedChildren;
+    // set while everything must be shown, e.g. to let searches find all nodes
+    bool m_fetchAll = false;
 
     friend class TestModels;
 };
@@ -240,6 +496,7 @@ public:
     {
         QAbstractItemModel::beginResetModel();
         m_results = data;
+        Base::updateCaches();
         QAbstractItemModel::endResetModel();
     }
 
@@ -278,6 +535,7 @@ public:
 private:
     QVariant headerColumnData(int column, int role) const final;
     QVariant rowData(const Data::BottomUp* row, int column, int role) const final;
+    qint64 rowCost(const Data::BottomUp* row, int column) const final;
     int numColumns() const final;
 };
 
@@ -304,6 +562,7 @@ public:
 private:
     QVariant headerColumnData(int column, int role) const final;
     QVariant rowData(const Data::TopDown* row, int column, int role) const final;
+    qint64 rowCost(const Data::TopDown* row, int column) const final;
     int numColumns() const final;
 };
 
@@ -330,5 +589,6 @@ public:
 private:
     QVariant headerColumnData(int column, int role) const final;
     QVariant rowData(const Data::PerLibrary* row, int column, int role) const final;
+    qint64 rowCost(const Data::PerLibrary* row, int column) const final;
     int numColumns() const final;
 };
@@ -14,8 +14,8 @@
 #include <QEventLoop>
 #include <QFileInfo>
 #include <QLoggingCategory>
+#include <QMutexLocker>
 #include <QProcess>
-#include <QScopeGuard>
 #include <QTemporaryFile>
 #include <QThread>
 #include <QTimer>
@@ -958,6 +958,9 @@ public:
         buildCallerCalleeResult();
 
         for (auto& thread : eventResult.threads) {
+            // off-CPU events get added when the thread gets switched in again, but carry the switch out time
+            Data::sortByTime(&thread.events);
+
             thread.time.start = std::max(thread.time.start, applicationTime.start);
             thread.time.end = std::min(thread.time.end, applicationTime.end);
             if (thread.name.isEmpty()) {
@@ -980,9 +983,12 @@ public:
             uint cpuId = 0;
             for (auto& cpu : eventResult.cpus) {
                 cpu.cpuId = cpuId++;
+                Data::sortByTime(&cpu.events);
             }
         }
 
+        Data::sortByTime(&tracepointResult.tracepoints);
+
         eventResult.totalCosts = summaryResult.costs;
 
         // Add error messages for all modules with missing debug symbols
@@ -1050,13 +1056,25 @@ public:
         thread.name = commands.names.value(thread.pid).value(thread.tid);
         if (thread.name.isEmpty() && thread.pid != thread.tid)
             thread.name = commands.names.value(thread.pid).value(thread.pid);
+        // when a tid gets reused, the lookup must find the newest thread, just like EventResults::findThread
+        threadIndices.insert({thread.pid, thread.tid}, eventResult.threads.size());
         eventResult.threads.push_back(thread);
         return &eventResult.threads.last();
     }
 
+    // like EventResults::findThread, but without a linear scan over all threads for every record
+    Data::ThreadEvents* findThread(qint32 pid, qint32 tid)
+    {
+        auto it = threadIndices.constFind({pid, tid});
+        if (it == threadIndices.constEnd()) {
+            return nullptr;
+        }
+        return &eventResult.threads[*it];
+    }
+
     void addThreadEnd(const ThreadEnd& threadEnd)
     {
-        auto* thread = eventResult.findThread(threadEnd.pid, threadEnd.tid);
+        auto* thread = findThread(threadEnd.pid, threadEnd.tid);
         if (thread) {
             thread->time.end = threadEnd.time;
         }
@@ -1066,7 +1084,7 @@ public:
     {
         const auto& comm = strings.value(command.comm.id);
         // check if this changes the name of a current thread
-        auto* thread = eventResult.findThread(command.pid, command.tid);
+        auto* thread = findThread(command.pid, command.tid);
         if (thread) {
             thread->name = comm;
         }
@@ -1122,42 +1140,9 @@ public:
         return id - 1;
     }
 
-    void addSampleToFrequencyData(const Sample& sample)
-    {
-        auto& lastTime = m_lastSampleTimePerCore[sample.cpu];
-        auto updateTime = qScopeGuard([&]() { lastTime = sample.time; });
-        if (!lastTime) {
-            return;
-        }
-
-        if (static_cast<quint32>(frequencyResult.cores.size()) <= sample.cpu) {
-            frequencyResult.cores.resize(sample.cpu + 1);
-        }
-
-        auto& core = frequencyResult.cores[sample.cpu];
-        for (const auto& cost : sample.costs) {
-            if (core.costs.size() <= cost.attributeId) {
-                const auto oldSize = core.costs.size();
-                const auto newSize = cost.attributeId + 1;
-                core.costs.resize(newSize);
-
-                for (int i = oldSize; i < newSize; i++) {
-                    core.costs[i].costName = strings.at(attributes[i].name.id);
-                }
-            }
-
-            auto& costs = core.costs[cost.attributeId];
-
-            auto frequency = static_cast<double>(cost.cost) / (sample.time - lastTime);
-            costs.values.push_back({sample.time, frequency});
-        }
-    }
-
     void addSample(const Sample& sample)
     {
-        addSampleToFrequencyData(sample);
-
-        auto* thread = eventResult.findThread(sample.pid, sample.tid);
+        auto* thread = findThread(sample.pid, sample.tid);
         if (!thread) {
             thread = addThread(sample);
         }
@@ -1165,17 +1150,23 @@ public:
             eventResult.cpus.resize(sample.cpu + 1);
         }
         auto& cpu = eventResult.cpus[sample.cpu];
+        const auto stackId = internStack(sample.frames);
 
         for (const auto& sampleCost : sample.costs) {
             Data::Event event;
             event.time = sample.time;
             event.cost = sampleCost.cost;
             event.type = attributeIdsToCostIds.value(sampleCost.attributeId, -1);
-            event.stackId = internStack(sample.frames);
+            event.stackId = stackId;
             event.cpuId = sample.cpu;
             thread->events.push_back(event);
             cpu.events.push_back(event);
 
+            if (m_schedSwitchCostId != -1 && event.type == m_schedSwitchCostId) {
+                // remember the stack to attribute the off-CPU time to it once we get switched in again
+                thread->lastSchedSwitchStackId = stackId;
+            }
+
             const auto attribute = attributes.value(event.type);
             if (attribute.type == static_cast<quint32>(AttributesDefinition::Type::Tracepoint)) {
                 Data::Tracepoint tracepoint;
@@ -1299,7 +1290,7 @@ public:
 
     void addContextSwitch(const ContextSwitchDefinition& contextSwitch)
     {
-        auto* thread = eventResult.findThread(contextSwitch.pid, contextSwitch.tid);
+        auto* thread = findThread(contextSwitch.pid, contextSwitch.tid);
         if (!thread) {
             return;
         }
@@ -1317,14 +1308,7 @@ public:
             totalCost.sampleCount++;
             totalCost.totalPeriod += switchTime;
 
-            qint32 stackId = -1;
-            if (!thread->events.isEmpty() && m_schedSwitchCostId != -1) {
-                auto it = std::find_if(thread->events.rbegin(), thread->events.rend(),
-                                       [this](const Data::Event& event) { return event.type == m_schedSwitchCostId; });
-                if (it != thread->events.rend()) {
-                    stackId = it->stackId;
-                }
-            }
+            const auto stackId = thread->lastSchedSwitchStackId;
             if (stackId != -1) {
                 const auto& frames = eventResult.stacks[stackId];
                 QSet<Data::Symbol> recursionGuard;
@@ -1366,7 +1350,7 @@ public:
         ++summaryResult.lostChunks;
         summaryResult.lostEvents += lost.lost;
 
-        auto* thread = eventResult.findThread(lost.pid, lost.tid);
+        auto* thread = findThread(lost.pid, lost.tid);
         if (!thread) {
             return;
         }
@@ -1471,18 +1455,17 @@ public:
     Data::ByFileResults byFileResult;
     Data::EventResults eventResult;
     Data::TracepointResults tracepointResult;
-    Data::FrequencyResults frequencyResult;
     Data::ThreadNames commands;
     std::unique_ptr<QTextStream> perfScriptOutput;
     QHash<qint32, SymbolCount> numSymbolsByModule;
     QSet<QString> encounteredErrors;
     QHash<QVector<qint32>, qint32> stacks;
+    QHash<QPair<qint32, qint32>, int> threadIndices;
     std::atomic<bool> stopRequested;
     QHash<qint32, qint32> attributeIdsToCostIds;
     QHash<int, qint32> attributeNameToCostIds;
     qint32 m_nextCostId = 0;
     qint32 m_schedSwitchCostId = -1;
-    QHash<quint32, quint64> m_lastSampleTimePerCore;
     Settings::CostAggregation costAggregation;
     bool perfMapFileExists = false;
     QHash<quint32, TracePointFormat> tracepointFormat;
@@ -1508,6 +1491,7 @@ PerfParser::PerfParser(QObject* parent)
     , m_isParsing(false)
     , m_stopRequested(false)
     , m_costAggregationChanged(false)
+    , m_filterGeneration(0)
 {
     qRegisterMetaType<Data::Summary>();
     qRegisterMetaType<Data::BottomUp>();
@@ -1520,8 +1504,8 @@ PerfParser::PerfParser(QObject* parent)
     qRegisterMetaType<Data::EventResults>();
     qRegisterMetaType<Data::PerLibraryResults>();
     qRegisterMetaType<Data::TracepointResults>();
-    qRegisterMetaType<Data::FrequencyResults>();
     qRegisterMetaType<Data::ThreadNames>();
+    qRegisterMetaType<Data::SymbolTable>();
 
     // set data via signal/slot connection to ensure we don't introduce a data race
     connect(this, &PerfParser::bottomUpDataAvailable, this, [this](const Data::BottomUpResults& data) {
@@ -1539,11 +1523,6 @@ PerfParser::PerfParser(QObject* parent)
             m_byFileResults = data;
         }
     });
-    connect(this, &PerfParser::frequencyDataAvailable, this, [this](const Data::FrequencyResults& data) {
-        if (m_frequencyResults.cores.isEmpty()) {
-            m_frequencyResults = data;
-        }
-    });
     connect(this, &PerfParser::eventsAvailable, this, [this](const Data::EventResults& data) {
         if (m_events.threads.isEmpty()) {
             m_events = data;
@@ -1554,6 +1533,9 @@ PerfParser::PerfParser(QObject* parent)
             m_tracepointResults = data;
         }
     });
+    // filtering never changes the symbols, so the table only gets built once after parsing
+    connect(this, &PerfParser::symbolTableAvailable, this,
+            [this](const Data::SymbolTable& symbolTable) { m_symbolTable = symbolTable; });
     connect(this, &PerfParser::threadNamesAvailable, this,
             [this](const Data::ThreadNames& threadNames) { m_threadNames = threadNames; });
     connect(this, &PerfParser::parsingStarted, this, [this]() {
@@ -1563,6 +1545,7 @@ PerfParser::PerfParser(QObject* parent)
 
     auto parsingStopped = [this] {
         m_isParsing = false;
+        m_isFiltering = false;
         m_decompressed = {};
     };
 
@@ -1677,7 +1660,7 @@ void PerfParser::startParseFile(const QString& path)
     m_byFileResults = {};
     m_tracepointResults = {};
     m_events = {};
-    m_frequencyResults = {};
+    m_symbolTable = {};
 
     auto debuginfodUrls = Settings::instance()->debuginfodUrls();
     const auto costAggregation = Settings::instance()->costAggregation();
@@ -1701,7 +1684,7 @@ void PerfParser::startParseFile(const QString& path)
             emit byFileDataAvailable(d.byFileResult);
             emit tracepointDataAvailable(d.tracepointResult);
             emit eventsAvailable(d.eventResult);
-            emit frequencyDataAvailable(d.frequencyResult);
+            emit symbolTableAvailable(Data::SymbolTable::fromSymbols(d.bottomUpResult.symbols));
             emit threadNamesAvailable(d.commands);
             emit perfMapFileExists(d.perfMapFileExists);
 
@@ -1816,21 +1799,63 @@ void PerfParser::startParseFile(const QString& path)
 
 void PerfParser::filterResults(const Data::FilterAction& filter)
 {
-    Q_ASSERT(!m_isParsing);
+    Q_ASSERT(!m_isParsing || m_isFiltering);
 
+    m_isFiltering = true;
     emit parsingStarted();
+
+    {
+        QMutexLocker lock(&m_pendingFilterMutex);
+        // bumping the generation cooperatively cancels any in-flight filter job
+        ++m_filterGeneration;
+        m_pendingFilter = filter;
+        m_pendingCostAggregation = Settings::instance()->costAggregation();
+        // a job that didn't start yet will pick up the newest filter, no need to enqueue another one
+        if (m_filterJobPending) {
+            return;
+        }
+        m_filterJobPending = true;
+    }
+
     using namespace ThreadWeaver;
-    const auto costAggregation = Settings::instance()->costAggregation();
-    stream() << make_job([this, filter, costAggregation]() {
+    stream() << make_job([this]() {
+        Data::FilterAction filter;
+        auto costAggregation = Settings::CostAggregation::BySymbol;
+        uint generation = 0;
+        {
+            QMutexLocker lock(&m_pendingFilterMutex);
+            filter = m_pendingFilter;
+            costAggregation = m_pendingCostAggregation;
+            generation = m_filterGeneration;
+            m_filterJobPending = false;
+        }
+
+        // a newer filter was requested in the meantime, our results would be outdated
+        auto isSuperseded = [this, generation]() { return generation != m_filterGeneration; };
+        auto isCancelled = [this, isSuperseded]() { return m_stopRequested || isSuperseded(); };
+        // superseded jobs silently make room for the newest one, only report explicit stop requests
+        // the generation is checked again in the GUI thread, where a newer filter request bumps it
+        auto abort = [this, generation]() {
+            QMetaObject::invokeMethod(
+                this,
+                [this, generation]() {
+                    if (generation == m_filterGeneration) {
+                        emit parsingFailed(tr("Parsing stopped."));
+                    }
+                },
+                Qt::QueuedConnection);
+        };
+
         Queue queue;
         queue.setMaximumNumberOfThreads(QThread::idealThreadCount());
 
+        // note: these are implicitly shared with the unfiltered data, the filter steps below must only
+        //       replace the parts that actually change to ensure we never copy the whole event set
         Data::BottomUpResults bottomUp;
         Data::EventResults events = m_events;
         Data::CallerCalleeResults callerCallee;
         Data::ByFileResults byFile;
         Data::TracepointResults tracepointResults = m_tracepointResults;
-        auto frequencyResults = m_frequencyResults;
         const bool filterByTime = filter.time.isValid();
         const bool filterByCpu = filter.cpuId != std::numeric_limits<quint32>::max();
         const bool excludeByCpu = !filter.excludeCpuIds.isEmpty();
@@ -1854,9 +1879,17 @@ void PerfParser::filterResults(const Data::FilterAction& filter)
             bottomUp.costs.clearTotalCost();
             const int numCosts = m_bottomUpResults.costs.numTypes();
 
-            // rebuild per-CPU data, i.e. wipe all the events and then re-add them
-            for (auto& cpu : events.cpus) {
-                cpu.events.clear();
+            // the events don't know their thread, so the per-CPU data gets rebuilt for thread filters
+            // i.e. we wipe all the events and then re-add them from the selected threads
+            // otherwise the per-CPU events get selected just like the thread events below
+            // when only the cost aggregation changed, the per-CPU data stays the same and can be shared
+            const bool filterByThread = filter.processId != Data::INVALID_PID || filter.threadId != Data::INVALID_TID
+                || !filter.excludeProcessIds.isEmpty() || !filter.excludeThreadIds.isEmpty();
+            const bool rebuildCpus = filterByThread;
+            if (rebuildCpus) {
+                for (auto& cpu : events.cpus) {
+                    cpu.events.clear();
+                }
             }
 
             // we filter all available stacks and then remember the stack ids that should be
@@ -1868,8 +1901,11 @@ void PerfParser::filterResults(const Data::FilterAction& filter)
                 const auto threadCount = queue.maximumNumberOfThreads();
                 const auto jobsPerThread = m_events.stacks.size() / threadCount;
 
-                auto filterStack = [&filter, &filterStacks, this](int start, int stop) {
+                auto filterStack = [&filter, &filterStacks, &isCancelled, this](int start, int stop) {
                     for (qint32 stackId = start, c = stop; stackId < c; ++stackId) {
+                        if ((stackId % 1024) == 0 && isCancelled()) {
+                            return;
+                        }
                         //  if empty, then all include filters are matched
                         auto includedSymbols = filter.includeSymbols;
                         auto includedBinaries = filter.includeBinaries;
@@ -1911,29 +1947,39 @@ void PerfParser::filterResults(const Data::FilterAction& filter)
             }
 
             if (filterByTime) {
-                auto it = std::remove_if(
-                    tracepointResults.tracepoints.begin(), tracepointResults.tracepoints.end(),
-                    [filter](const Data::Tracepoint& tracepoint) { return !filter.time.contains(tracepoint.time); });
-                tracepointResults.tracepoints.erase(it, tracepointResults.tracepoints.end());
-
-                for (auto& core : frequencyResults.cores) {
-                    for (auto& costType : core.costs) {
-
-                        auto frequencyIt = std::remove_if(
-                            costType.values.begin(), costType.values.end(),
-                            [filter](Data::FrequencyData point) { return !filter.time.contains(point.time); });
-                        costType.values.erase(frequencyIt, costType.values.end());
-                    }
-                }
+                tracepointResults.tracepoints = Data::clipToTimeRange(tracepointResults.tracepoints, filter.time);
             }
 
             queue.finish();
 
+            auto keepEvent = [&filter, filterByCpu, excludeByCpu, filterByStack,
+                              &filterStacks](const Data::Event& event) {
+                return !(filterByCpu && event.cpuId != filter.cpuId)
+                    && !(excludeByCpu && filter.excludeCpuIds.contains(event.cpuId))
+                    && !(filterByStack && event.stackId != -1 && !filterStacks[event.stackId]);
+            };
+
+            if (!rebuildCpus) {
+                // like for the threads, nothing gets copied for CPUs that keep all of their events
+                for (auto& cpu : events.cpus) {
+                    if (isCancelled()) {
+                        abort();
+                        return;
+                    }
+                    if (filterByTime) {
+                        cpu.events = Data::clipToTimeRange(cpu.events, filter.time);
+                    }
+                    if (filterByCpu || excludeByCpu || filterByStack) {
+                        cpu.events = Data::selectItems(cpu.events, keepEvent);
+                    }
+                }
+            }
+
             // remove events that lie outside the selected time span
             // TODO: parallelize
             for (auto& thread : events.threads) {
-                if (m_stopRequested) {
-                    emit parsingFailed(tr("Parsing stopped."));
+                if (isCancelled()) {
+                    abort();
                     return;
                 }
 
@@ -1945,33 +1991,38 @@ void PerfParser::filterResults(const Data::FilterAction& filter)
                     continue;
                 }
 
-                if (filterByTime || filterByCpu || excludeByCpu || filterByStack) {
-                    auto it = std::remove_if(thread.events.begin(), thread.events.end(),
-                                             [filter, filterByTime, filterByCpu, excludeByCpu, filterByStack,
-                                              filterStacks](const Data::Event& event) {
-                                                 return (filterByTime && !filter.time.contains(event.time))
-                                                     || (filterByCpu && event.cpuId != filter.cpuId)
-                                                     || (excludeByCpu && filter.excludeCpuIds.contains(event.cpuId))
-                                                     || (filterByStack && event.stackId != -1
-                                                         && !filterStacks[event.stackId]);
-                                             });
-                    thread.events.erase(it, thread.events.end());
+                if (filterByTime) {
+                    // the events are sorted by time, so this only needs two binary searches
+                    thread.events = Data::clipToTimeRange(thread.events, filter.time);
                 }
 
-                if (m_stopRequested) {
-                    emit parsingFailed(tr("Parsing stopped."));
+                if (filterByCpu || excludeByCpu || filterByStack) {
+                    thread.events = Data::selectItems(thread.events, keepEvent);
+                }
+
+                if (isCancelled()) {
+                    abort();
                     return;
                 }
 
                 // add event data to cpus, bottom up and caller callee sets
+                int numProcessedEvents = 0;
                 for (const auto& event : std::as_const(thread.events)) {
-                    // only add non-time events to the cpu line, context switches shouldn't show up there
-                    if (event.type == events.lostEventCostId) {
-                        // the lost event never has a valid cpu set, add to all CPUs
-                        for (auto& cpu : events.cpus)
-                            cpu.events.push_back(event);
-                    } else if (event.type != events.offCpuTimeCostId) {
-                        events.cpus[event.cpuId].events.push_back(event);
+                    // a single thread can hold millions of events, don't wait for it to finish when cancelled
+                    if ((++numProcessedEvents % 4096) == 0 && isCancelled()) {
+                        abort();
+                        return;
+                    }
+
+                    if (rebuildCpus) {
+                        // only add non-time events to the cpu line, context switches shouldn't show up there
+                        if (event.type == events.lostEventCostId) {
+                            // the lost event never has a valid cpu set, add to all CPUs
+                            for (auto& cpu : events.cpus)
+                                cpu.events.push_back(event);
+                        } else if (event.type != events.offCpuTimeCostId) {
+                            events.cpus[event.cpuId].events.push_back(event);
+                        }
                     }
 
                     QSet<Data::Symbol> recursionGuard;
@@ -1991,6 +2042,13 @@ void PerfParser::filterResults(const Data::FilterAction& filter)
                 }
             }
 
+            if (rebuildCpus) {
+                // the per-CPU events got added thread by thread, restore the time order
+                for (auto& cpu : events.cpus) {
+                    Data::sortByTime(&cpu.events);
+                }
+            }
+
             // remove threads that have no events within the selected time span
             auto it = std::remove_if(events.threads.begin(), events.threads.end(),
                                      [](const Data::ThreadEvents& thread) { return thread.events.isEmpty(); });
@@ -1998,8 +2056,8 @@ void PerfParser::filterResults(const Data::FilterAction& filter)
 
             Data::BottomUp::initializeParents(&bottomUp.root);
 
-            if (m_stopRequested) {
-                emit parsingFailed(tr("Parsing stopped."));
+            if (isCancelled()) {
+                abort();
                 return;
             }
 
@@ -2007,8 +2065,8 @@ void PerfParser::filterResults(const Data::FilterAction& filter)
             Data::callerCalleesFromBottomUpData(bottomUp, &callerCallee);
         }
 
-        if (m_stopRequested) {
-            emit parsingFailed(tr("Parsing stopped."));
+        if (isCancelled()) {
+            abort();
             return;
         }
 
@@ -2016,22 +2074,35 @@ void PerfParser::filterResults(const Data::FilterAction& filter)
             Data::TopDownResults::fromBottomUp(bottomUp, costAggregation != Settings::CostAggregation::BySymbol);
         const auto perLibrary = Data::PerLibraryResults::fromTopDown(topDown);
 
-        if (m_stopRequested) {
-            emit parsingFailed(tr("Parsing stopped."));
+        if (isCancelled()) {
+            abort();
             return;
         }
 
-        m_costAggregationChanged = false;
+        // only the newest result gets published, a filter request may come in while the results are queued
+        // so the generation is compared in the GUI thread, which also keeps m_isFiltering set for newer jobs
+        QMetaObject::invokeMethod(
+            this,
+            [this, generation, bottomUp = std::move(bottomUp), topDown, perLibrary,
+             callerCallee = std::move(callerCallee), byFile = std::move(byFile),
+             tracepointResults = std::move(tracepointResults), events = std::move(events)]() {
+                if (generation != m_filterGeneration) {
+                    return;
+                }
 
-        emit bottomUpDataAvailable(bottomUp);
-        emit topDownDataAvailable(topDown);
-        emit perLibraryDataAvailable(perLibrary);
-        emit callerCalleeDataAvailable(callerCallee);
-        emit byFileDataAvailable(byFile);
-        emit frequencyDataAvailable(frequencyResults);
-        emit tracepointDataAvailable(tracepointResults);
-        emit eventsAvailable(events);
-        emit parsingFinished();
+                m_costAggregationChanged = false;
+
+                emit bottomUpDataAvailable(bottomUp);
+                emit topDownDataAvailable(topDown);
+                emit perLibraryDataAvailable(perLibrary);
+                emit callerCalleeDataAvailable(callerCallee);
+                emit byFileDataAvailable(byFile);
+                emit tracepointDataAvailable(tracepointResults);
+                emit eventsAvailable(events);
+                emit symbolTableAvailable(m_symbolTable);
+                emit parsingFinished();
+            },
+            Qt::QueuedConnection);
     });
 }
 
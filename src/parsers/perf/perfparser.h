@@ -9,10 +9,13 @@
 
 #include <atomic>
 #include <memory>
+#include <QMutex>
 #include <QObject>
 
 #include <models/data.h>
 
+#include "settings.h"
+
 class QUrl;
 class QTemporaryFile;
 
@@ -56,12 +59,12 @@ signals:
     void parsingStarted();
     void summaryDataAvailable(const Data::Summary& data);
     void bottomUpDataAvailable(const Data::BottomUpResults& data);
+    void symbolTableAvailable(const Data::SymbolTable& symbolTable);
     void topDownDataAvailable(const Data::TopDownResults& data);
     void perLibraryDataAvailable(const Data::PerLibraryResults& data);
     void callerCalleeDataAvailable(const Data::CallerCalleeResults& data);
     void byFileDataAvailable(const Data::ByFileResults& data);
     void tracepointDataAvailable(const Data::TracepointResults& data);
-    void frequencyDataAvailable(const Data::FrequencyResults& data);
     void eventsAvailable(const Data::EventResults& events);
     void threadNamesAvailable(const Data::ThreadNames& threadNames);
     void parsingFinished();
@@ -89,10 +92,18 @@ private:
     Data::ByFileResults m_byFileResults;
     Data::TracepointResults m_tracepointResults;
     Data::EventResults m_events;
-    Data::FrequencyResults m_frequencyResults;
+    Data::SymbolTable m_symbolTable;
     std::atomic<bool> m_isParsing;
     std::atomic<bool> m_stopRequested;
     std::atomic<bool> m_costAggregationChanged;
+    // bumped for every filter request, in-flight filter jobs with an older generation abort cooperatively
+    std::atomic<uint> m_filterGeneration;
+    // protects the pending filter state below, which is shared between the GUI thread and the filter job
+    QMutex m_pendingFilterMutex;
+    Data::FilterAction m_pendingFilter;
+    Settings::CostAggregation m_pendingCostAggregation = Settings::CostAggregation::BySymbol;
+    bool m_filterJobPending = false;
+    bool m_isFiltering = false;
     std::unique_ptr<QTemporaryFile> m_decompressed;
     Data::ThreadNames m_threadNames;
 };
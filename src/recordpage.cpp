@@ -671,7 +671,9 @@ void RecordPage::stopRecording()
 
 void RecordPage::updateProcesses()
 {
-    m_watcher->setFuture(QtConcurrent::run(processList));
+    // only new processes need to be looked at in detail, pass the ones we already know about
+    m_watcher->setFuture(
+        QtConcurrent::run([knownProcesses = m_processModel->processes()]() { return processList(knownProcesses); }));
 }
 
 void RecordPage::updateProcessesFinished()
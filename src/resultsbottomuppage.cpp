@@ -66,6 +66,10 @@ ResultsBottomUpPage::ResultsBottomUpPage(FilterAndZoomStack* filterStack, PerfPa
     ResultsUtil::setupCostDelegate(bottomUpCostModel, ui->bottomUpTreeView);
     ResultsUtil::setupContextMenu(ui->bottomUpTreeView, contextMenu, bottomUpCostModel, filterStack, this);
 
+    connect(parser, &PerfParser::symbolTableAvailable, this, [this](const Data::SymbolTable& symbolTable) {
+        ResultsUtil::setSymbolTable(ui->bottomUpTreeView, symbolTable);
+    });
+
     connect(
         parser, &PerfParser::bottomUpDataAvailable, this,
         [this, bottomUpCostModel, exportMenu](const Data::BottomUpResults& data) {
@@ -24,6 +24,7 @@
 #include "models/disassemblyoutput.h"
 #include "models/filterandzoomstack.h"
 #include "models/hashmodel.h"
+#include "models/sourcefilecache.h"
 #include "models/treemodel.h"
 
 #include <QPushButton>
@@ -93,6 +94,10 @@ ResultsCallerCalleePage::ResultsCallerCalleePage(FilterAndZoomStack* filterStack
     ResultsUtil::setupHeaderView(ui->callerCalleeTableView, contextMenu);
     ResultsUtil::setupCostDelegate(m_callerCalleeCostModel, ui->callerCalleeTableView);
 
+    connect(parser, &PerfParser::symbolTableAvailable, this, [this](const Data::SymbolTable& symbolTable) {
+        ResultsUtil::setSymbolTable(ui->callerCalleeTableView, symbolTable);
+    });
+
     connect(parser, &PerfParser::callerCalleeDataAvailable, this, [this](const Data::CallerCalleeResults& data) {
         m_callerCalleeCostModel->setResults(data);
         ResultsUtil::hideEmptyColumns(data.inclusiveCosts, ui->callerCalleeTableView,
@@ -285,8 +290,8 @@ void ResultsCallerCalleePage::openEditor(const Data::Symbol& symbol)
         if (location) {
             auto settings = Settings::instance();
             const auto colon = QLatin1Char(':');
-            auto remappedSourceFile =
-                findSourceCodeFile(location.path, settings->sourceCodePaths().split(colon), settings->sysroot());
+            auto remappedSourceFile = SourceFileCache::instance()->resolve(
+                location.path, settings->sourceCodePaths().split(colon), settings->sysroot());
             emit navigateToCode(remappedSourceFile, location.lineNumber, 0);
             return true;
         }
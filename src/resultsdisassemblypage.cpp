@@ -10,6 +10,7 @@
 #include "ui_resultsdisassemblypage.h"
 
 #include <QActionGroup>
+#include <QApplication>
 #include <QDir>
 #include <QDirIterator>
 #include <QFile>
@@ -19,13 +20,17 @@
 #include <QMessageBox>
 #include <QPainter>
 #include <QProcess>
+#include <QPromise>
 #include <QStandardItemModel>
 #include <QStandardPaths>
 #include <QString>
 #include <QTemporaryFile>
 #include <QTextStream>
+#include <QTimer>
 #include <QVarLengthArray>
+#include <QtConcurrent/QtConcurrentRun>
 
+#include <KBusyIndicatorWidget>
 #include <KColorScheme>
 #include <KStandardAction>
 
@@ -42,9 +47,11 @@
 #include "data.h"
 #include "models/codedelegate.h"
 #include "models/costdelegate.h"
+#include "models/disassemblycache.h"
 #include "models/disassemblymodel.h"
 #include "models/search.h"
 #include "models/sourcecodemodel.h"
+#include "models/sourcefilecache.h"
 #include "settings.h"
 
 namespace {
@@ -236,6 +243,8 @@ ResultsDisassemblyPage::ResultsDisassemblyPage(CostContextMenu* costContextMenu,
     , m_sourceCodeDelegate(new CodeDelegate(SourceCodeModel::RainbowLineNumberRole, SourceCodeModel::HighlightRole,
                                             SourceCodeModel::SyntaxHighlightRole, this))
     , m_branchesDelegate(new BranchDelegate(this))
+    , m_busyIndicator(new KBusyIndicatorWidget(this))
+    , m_prefetchTimer(new QTimer(this))
 {
     // TODO: the auto resize behavior is broken with these models that don't have the stretch column on the left
     auto setCostHeader = [this, costContextMenu](QTreeView* view) {
@@ -245,6 +254,17 @@ ResultsDisassemblyPage::ResultsDisassemblyPage(CostContextMenu* costContextMenu,
     };
 
     ui->setupUi(this);
+    ui->horizontalLayout_5->insertWidget(0, m_busyIndicator);
+    m_busyIndicator->setToolTip(tr("Disassembling..."));
+    m_busyIndicator->hide();
+
+    // wait for the user to be idle for a moment before prefetching the next binary
+    m_prefetchTimer->setSingleShot(true);
+    m_prefetchTimer->setInterval(1000);
+    connect(m_prefetchTimer, &QTimer::timeout, this, &ResultsDisassemblyPage::prefetchNextBinary);
+    m_lastInteraction.start();
+    qApp->installEventFilter(this);
+
     ui->assemblyView->setModel(m_disassemblyModel);
     ui->assemblyView->setMouseTracking(true);
     setCostHeader(ui->assemblyView);
@@ -284,6 +304,14 @@ ResultsDisassemblyPage::ResultsDisassemblyPage(CostContextMenu* costContextMenu,
     m_sourceCodeModel->highlightedText()->updateTabWidth(settings->tabWidth());
     m_disassemblyModel->highlightedText()->updateTabWidth(settings->tabWidth());
 
+    auto updateDisassemblyCache = [](bool persistent) {
+        DisassemblyCache::instance()->setDiskCacheDirectory(
+            persistent ? DisassemblyCache::defaultDiskCacheDirectory() : QString());
+    };
+    connect(settings, &Settings::persistentDisassemblyCacheChanged, this, updateDisassemblyCache);
+    updateDisassemblyCache(settings->persistentDisassemblyCache());
+    connect(settings, &Settings::disassemblyPrefetchDepthChanged, this, &ResultsDisassemblyPage::schedulePrefetch);
+
     auto createContextMenu = [](QTreeView* view, auto* model, auto&& addEntries) {
         auto gotoMenuWidget = new QWidget(view);
         auto layout = new QHBoxLayout(gotoMenuWidget);
@@ -518,12 +546,22 @@ ResultsDisassemblyPage::ResultsDisassemblyPage(CostContextMenu* costContextMenu,
 #endif
 }
 
-ResultsDisassemblyPage::~ResultsDisassemblyPage() = default;
+ResultsDisassemblyPage::~ResultsDisassemblyPage()
+{
+    m_disassemblyFuture.cancel();
+    m_prefetchFuture.cancel();
+}
 
 void ResultsDisassemblyPage::clear()
 {
+    ++m_currentDisassemblyId;
+    m_disassemblyFuture.cancel();
+    m_busyIndicator->hide();
+
     m_disassemblyModel->clear();
     m_sourceCodeModel->clear();
+    // the sources might have changed in the meantime and missing files could show up now
+    SourceFileCache::instance()->clear();
 }
 
 void ResultsDisassemblyPage::setupAsmViewModel()
@@ -568,35 +606,40 @@ void ResultsDisassemblyPage::showDisassembly()
         clear();
     }
 
-    // TODO: add the ability to configure the arch <-> objdump mapping somehow in the settings
-    const auto objdump = [this](const QString& objdump) {
-        if (!objdump.isEmpty())
-            return objdump;
-
-        if (m_arch.startsWith(QLatin1String("armv8")) || m_arch.startsWith(QLatin1String("aarch64"))) {
-            if (auto aarch64Objdump = QStandardPaths::findExecutable(QStringLiteral("aarch64-linux-gnu-objdump"));
-                !aarch64Objdump.isEmpty())
-                return QStringLiteral("aarch64-linux-gnu-objdump");
-        }
-
-        if (m_arch.startsWith(QLatin1String("arm"))) {
-            if (auto armObjdump = QStandardPaths::findExecutable(QStringLiteral("arm-linux-gnueabi-objdump"));
-                !armObjdump.isEmpty())
-                return QStringLiteral("arm-linux-gnueabi-objdump");
-        }
-
-        return QStringLiteral("objdump");
-    };
-
     ui->symbolNotFound->hide();
 
     auto settings = Settings::instance();
     const auto colon = QLatin1Char(':');
 
-    showDisassembly(
-        DisassemblyOutput::disassemble(objdump(settings->objdump()), m_arch, settings->debugPaths().split(colon),
-                                       settings->extraLibPaths().split(colon), settings->sourceCodePaths().split(colon),
-                                       settings->sysroot(), curSymbol));
+    // the result for the previously shown symbol isn't needed anymore
+    const auto disassemblyId = ++m_currentDisassemblyId;
+    m_disassemblyFuture.cancel();
+    m_busyIndicator->show();
+
+    // don't let the prefetching compete with the disassembly the user is waiting for
+    if (m_prefetchFuture.isRunning()) {
+        m_prefetchFuture.cancel();
+        m_prefetchQueue.prepend(m_prefetchingSymbols);
+        m_prefetchingSymbols.clear();
+        m_prefetchTimer->start();
+    }
+
+    m_disassemblyFuture = QtConcurrent::run(
+        [objdump = objdump(), arch = m_arch, debugPaths = settings->debugPaths().split(colon),
+         extraLibPaths = settings->extraLibPaths().split(colon),
+         sourceCodePaths = settings->sourceCodePaths().split(colon), sysroot = settings->sysroot(),
+         symbol = curSymbol](QPromise<DisassemblyOutput>& promise) {
+            promise.addResult(DisassemblyOutput::disassemble(objdump, arch, debugPaths, extraLibPaths,
+                                                             sourceCodePaths, sysroot, symbol,
+                                                             [&promise]() { return promise.isCanceled(); }));
+        });
+    m_disassemblyFuture.then(this, [this, disassemblyId](const DisassemblyOutput& disassemblyOutput) {
+        if (disassemblyId != m_currentDisassemblyId) {
+            return;
+        }
+        m_busyIndicator->hide();
+        showDisassembly(disassemblyOutput);
+    });
 }
 
 void ResultsDisassemblyPage::showDisassembly(const DisassemblyOutput& disassemblyOutput)
@@ -662,6 +705,7 @@ void ResultsDisassemblyPage::setSymbol(const Data::Symbol& symbol)
 void ResultsDisassemblyPage::setCostsMap(const Data::CallerCalleeResults& callerCalleeResults)
 {
     m_callerCalleeResults = callerCalleeResults;
+    schedulePrefetch();
 }
 
 void ResultsDisassemblyPage::setArch(const QString& arch)
@@ -677,6 +721,121 @@ void ResultsDisassemblyPage::changeEvent(QEvent* event)
     }
 }
 
+bool ResultsDisassemblyPage::eventFilter(QObject* watched, QEvent* event)
+{
+    switch (event->type()) {
+    case QEvent::KeyPress:
+    case QEvent::MouseButtonPress:
+    case QEvent::Wheel:
+        m_lastInteraction.restart();
+        break;
+    default:
+        break;
+    }
+    return QWidget::eventFilter(watched, event);
+}
+
+QString ResultsDisassemblyPage::objdump() const
+{
+    const auto objdump = Settings::instance()->objdump();
+    if (!objdump.isEmpty())
+        return objdump;
+
+    // TODO: add the ability to configure the arch <-> objdump mapping somehow in the settings
+    if (m_arch.startsWith(QLatin1String("armv8")) || m_arch.startsWith(QLatin1String("aarch64"))) {
+        if (auto aarch64Objdump = QStandardPaths::findExecutable(QStringLiteral("aarch64-linux-gnu-objdump"));
+            !aarch64Objdump.isEmpty())
+            return QStringLiteral("aarch64-linux-gnu-objdump");
+    }
+
+    if (m_arch.startsWith(QLatin1String("arm"))) {
+        if (auto armObjdump = QStandardPaths::findExecutable(QStringLiteral("arm-linux-gnueabi-objdump"));
+            !armObjdump.isEmpty())
+            return QStringLiteral("arm-linux-gnueabi-objdump");
+    }
+
+    return QStringLiteral("objdump");
+}
+
+void ResultsDisassemblyPage::schedulePrefetch()
+{
+    m_prefetchFuture.cancel();
+    m_prefetchQueue.clear();
+    m_prefetchingSymbols.clear();
+    m_prefetchTimer->stop();
+
+    const auto depth = Settings::instance()->disassemblyPrefetchDepth();
+    const auto& selfCosts = m_callerCalleeResults.selfCosts;
+    if (depth <= 0 || selfCosts.numTypes() == 0) {
+        return;
+    }
+
+    struct HotSymbol
+    {
+        Data::Symbol symbol;
+        qint64 cost;
+    };
+    QVector<HotSymbol> hotSymbols;
+    hotSymbols.reserve(m_callerCalleeResults.entries.size());
+    for (auto it = m_callerCalleeResults.entries.cbegin(), end = m_callerCalleeResults.entries.cend(); it != end;
+         ++it) {
+        const auto cost = selfCosts.cost(0, it->id);
+        if (cost > 0 && it.key().canDisassemble()) {
+            hotSymbols.append({it.key(), cost});
+        }
+    }
+
+    const auto numHotSymbols = std::min<qsizetype>(depth, hotSymbols.size());
+    std::partial_sort(hotSymbols.begin(), hotSymbols.begin() + numHotSymbols, hotSymbols.end(),
+                      [](const HotSymbol& lhs, const HotSymbol& rhs) { return lhs.cost > rhs.cost; });
+
+    // one objdump run per binary, starting with the binary of the hottest symbol
+    QHash<QString, int> binaryIndices;
+    for (int i = 0; i < numHotSymbols; ++i) {
+        const auto& symbol = hotSymbols[i].symbol;
+        auto it = binaryIndices.find(symbol.binary);
+        if (it == binaryIndices.end()) {
+            it = binaryIndices.insert(symbol.binary, m_prefetchQueue.size());
+            m_prefetchQueue.append({});
+        }
+        m_prefetchQueue[*it].append(symbol);
+    }
+
+    if (!m_prefetchQueue.isEmpty()) {
+        m_prefetchTimer->start();
+    }
+}
+
+void ResultsDisassemblyPage::prefetchNextBinary()
+{
+    if (m_prefetchQueue.isEmpty()) {
+        return;
+    }
+
+    // back off while the user is busy, a canceled job may also still be shutting down
+    if (m_lastInteraction.elapsed() < m_prefetchTimer->interval() || m_disassemblyFuture.isRunning()
+        || m_prefetchFuture.isRunning()) {
+        m_prefetchTimer->start();
+        return;
+    }
+
+    m_prefetchingSymbols = m_prefetchQueue.takeFirst();
+
+    auto settings = Settings::instance();
+    const auto colon = QLatin1Char(':');
+    m_prefetchFuture = QtConcurrent::run([objdump = objdump(), debugPaths = settings->debugPaths().split(colon),
+                                          extraLibPaths = settings->extraLibPaths().split(colon),
+                                          symbols = m_prefetchingSymbols](QPromise<void>& promise) {
+        DisassemblyOutput::prefetch(objdump, debugPaths, extraLibPaths, symbols,
+                                    [&promise]() { return promise.isCanceled(); });
+    });
+    // canceled jobs don't continue, the queue got reset or requeued those symbols already
+    m_prefetchFuture.then(this, [this]() {
+        m_prefetchingSymbols.clear();
+        m_prefetchTimer->start();
+    });
+}
+
 void ResultsDisassemblyPage::jumpToSourceLine(const Data::FileLine& line)
 {
     if (line.isValid()) {
@@ -12,11 +12,15 @@
 #include "hotspot-config.h"
 #include "models/costdelegate.h"
 
+#include <QElapsedTimer>
+#include <QFuture>
 #include <QWidget>
 
 #include <memory>
 
 class QStyledItemDelegate;
+class QTimer;
+class KBusyIndicatorWidget;
 
 namespace Ui {
 class ResultsDisassemblyPage;
@@ -60,11 +64,15 @@ signals:
 
 protected:
     void changeEvent(QEvent* event) override;
+    bool eventFilter(QObject* watched, QEvent* event) override;
 
 private:
     void setupAsmViewModel();
     void showDisassembly(const DisassemblyOutput& disassemblyOutput);
     void showDisassembly();
+    QString objdump() const;
+    void schedulePrefetch();
+    void prefetchNextBinary();
 
     std::unique_ptr<Ui::ResultsDisassemblyPage> ui;
 #if KFSyntaxHighlighting_FOUND
@@ -88,4 +96,17 @@ private:
 
     QVector<Data::Symbol> m_symbolStack;
     int m_stackIndex = 0;
+
+    KBusyIndicatorWidget* m_busyIndicator;
+    // objdump runs in the background, the job gets canceled when another symbol is shown
+    QFuture<DisassemblyOutput> m_disassemblyFuture;
+    uint m_currentDisassemblyId = 0;
+
+    // the hottest symbols get disassembled in the background, one binary at a time
+    QVector<QVector<Data::Symbol>> m_prefetchQueue;
+    QVector<Data::Symbol> m_prefetchingSymbols;
+    QFuture<void> m_prefetchFuture;
+    QTimer* m_prefetchTimer;
+    // prefetching backs off while the user is interacting with the application
+    QElapsedTimer m_lastInteraction;
 };
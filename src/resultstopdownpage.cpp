@@ -27,6 +27,10 @@ ResultsTopDownPage::ResultsTopDownPage(FilterAndZoomStack* filterStack, PerfPars
     ResultsUtil::setupCostDelegate(topDownCostModel, ui->topDownTreeView);
     ResultsUtil::setupContextMenu(ui->topDownTreeView, contextMenu, topDownCostModel, filterStack, this);
 
+    connect(parser, &PerfParser::symbolTableAvailable, this, [this](const Data::SymbolTable& symbolTable) {
+        ResultsUtil::setSymbolTable(ui->topDownTreeView, symbolTable);
+    });
+
     connect(parser, &PerfParser::topDownDataAvailable, this,
             [this, topDownCostModel](const Data::TopDownResults& data) {
                 topDownCostModel->setData(data);
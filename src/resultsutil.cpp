@@ -49,7 +49,12 @@ void connectFilter(QLineEdit* filter, QSortFilterProxyModel* proxy, QCheckBox* r
     auto setFilterNeedle = [filter, proxy, regexCheckBox]() {
         auto useRegex = regexCheckBox->isChecked();
         const auto needle = filter->text();
-        proxy->setFilterRegularExpression(useRegex ? needle : QRegularExpression::escape(needle));
+        const auto search = useRegex ? needle : QRegularExpression::escape(needle);
+        if (auto* symbolProxy = qobject_cast<SymbolFilterProxy*>(proxy)) {
+            symbolProxy->setSearch(search);
+        } else {
+            proxy->setFilterRegularExpression(search);
+        }
     };
 
     QObject::connect(timer, &QTimer::timeout, proxy, setFilterNeedle);
@@ -63,6 +68,13 @@ void connectFilter(QLineEdit* filter, QSortFilterProxyModel* proxy, QCheckBox* r
     QObject::connect(filter, &QLineEdit::textChanged, timer, [timer]() { timer->start(300); });
 }
 
+void setSymbolTable(QAbstractItemView* view, const Data::SymbolTable& symbolTable)
+{
+    auto* proxy = qobject_cast<SymbolFilterProxy*>(view->model());
+    Q_ASSERT(proxy);
+    proxy->setSymbolTable(symbolTable);
+}
+
 void setupTreeView(QTreeView* view, CostContextMenu* contextMenu, QLineEdit* filter, QCheckBox* regexSearchCheckbox,
                    QSortFilterProxyModel* model, int initialSortColumn, int sortRole)
 {
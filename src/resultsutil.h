@@ -13,6 +13,7 @@
 #include "models/costproxy.h"
 #include <QFlags>
 
+class QAbstractItemView;
 class QMenu;
 class QTreeView;
 class QComboBox;
@@ -24,6 +25,7 @@ class QCheckBox;
 namespace Data {
 class Costs;
 struct Symbol;
+struct SymbolTable;
 }
 
 class FilterAndZoomStack;
@@ -34,6 +36,9 @@ void setupHeaderView(QTreeView* view, CostContextMenu* contextMenu);
 
 void connectFilter(QLineEdit* filter, QSortFilterProxyModel* proxy, QCheckBox* regexCheckBox);
 
+// lets the SymbolFilterProxy of @p view match searches once per symbol of @p symbolTable
+void setSymbolTable(QAbstractItemView* view, const Data::SymbolTable& symbolTable);
+
 void setupTreeView(QTreeView* view, CostContextMenu* contextMenu, QLineEdit* filter, QCheckBox* regexSearchCheckBox,
                    QSortFilterProxyModel* model, int initialSortColumn, int sortRole);
 
@@ -258,6 +258,18 @@ void Settings::loadFromFile()
     connect(this, &Settings::tabWidthChanged, [sharedConfig](int distance) {
         sharedConfig->group(QStringLiteral("Disassembly")).writeEntry("tabWidth", distance);
     });
+
+    setPersistentDisassemblyCache(
+        sharedConfig->group(QStringLiteral("Disassembly")).readEntry("persistentCache", false));
+    connect(this, &Settings::persistentDisassemblyCacheChanged, [sharedConfig](bool persistentDisassemblyCache) {
+        sharedConfig->group(QStringLiteral("Disassembly")).writeEntry("persistentCache", persistentDisassemblyCache);
+    });
+
+    setDisassemblyPrefetchDepth(
+        sharedConfig->group(QStringLiteral("Disassembly")).readEntry("prefetchDepth", DefaultDisassemblyPrefetchDepth));
+    connect(this, &Settings::disassemblyPrefetchDepthChanged, [sharedConfig](int depth) {
+        sharedConfig->group(QStringLiteral("Disassembly")).writeEntry("prefetchDepth", depth);
+    });
 }
 
 void Settings::setSourceCodePaths(const QString& paths)
@@ -299,3 +311,19 @@ void Settings::setTabWidth(int distance)
         emit tabWidthChanged(m_tabWidth);
     }
 }
+
+void Settings::setPersistentDisassemblyCache(bool persistentDisassemblyCache)
+{
+    if (m_persistentDisassemblyCache != persistentDisassemblyCache) {
+        m_persistentDisassemblyCache = persistentDisassemblyCache;
+        emit persistentDisassemblyCacheChanged(m_persistentDisassemblyCache);
+    }
+}
+
+void Settings::setDisassemblyPrefetchDepth(int depth)
+{
+    if (m_disassemblyPrefetchDepth != depth) {
+        m_disassemblyPrefetchDepth = depth;
+        emit disassemblyPrefetchDepthChanged(m_disassemblyPrefetchDepth);
+    }
+}
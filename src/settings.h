@@ -168,6 +168,18 @@ public:
         return m_tabWidth;
     }
 
+    bool persistentDisassemblyCache() const
+    {
+        return m_persistentDisassemblyCache;
+    }
+
+    int disassemblyPrefetchDepth() const
+    {
+        return m_disassemblyPrefetchDepth;
+    }
+
+    static constexpr int DefaultDisassemblyPrefetchDepth = 20;
+
     static constexpr int DefaultTabWidth = 4;
 
     void loadFromFile();
@@ -195,6 +207,8 @@ signals:
     void showBranchesChanged(bool showBranches);
     void showHexdumpChanged(bool showHexdump);
     void tabWidthChanged(int distance);
+    void persistentDisassemblyCacheChanged(bool persistentDisassemblyCache);
+    void disassemblyPrefetchDepthChanged(int depth);
 
 public slots:
     void setPrettifySymbols(bool prettifySymbols);
@@ -221,6 +235,8 @@ public slots:
     void setShowBranches(bool showBranches);
     void setShowHexdump(bool showHexdump);
     void setTabWidth(int distance);
+    void setPersistentDisassemblyCache(bool persistentDisassemblyCache);
+    void setDisassemblyPrefetchDepth(int depth);
 
 private:
     using QObject::QObject;
@@ -247,6 +263,8 @@ private:
     bool m_showBranches = true;
     bool m_showHexdump = false;
     int m_tabWidth = DefaultTabWidth;
+    bool m_persistentDisassemblyCache = false;
+    int m_disassemblyPrefetchDepth = DefaultDisassemblyPrefetchDepth;
 
     QString m_lastUsedEnvironment;
 
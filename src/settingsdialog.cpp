@@ -353,12 +353,16 @@ void SettingsDialog::addSourcePathPage()
     disassemblyPage->showBranches->setChecked(settings->showBranches());
     disassemblyPage->showHexdump->setChecked(settings->showHexdump());
     disassemblyPage->tabWidth->setValue(settings->tabWidth());
+    disassemblyPage->persistentCache->setChecked(settings->persistentDisassemblyCache());
+    disassemblyPage->prefetchDepth->setValue(settings->disassemblyPrefetchDepth());
 
     connect(buttonBox(), &QDialogButtonBox::accepted, this, [this, colon, settings] {
         settings->setSourceCodePaths(disassemblyPage->sourcePaths->items().join(colon));
         settings->setShowBranches(disassemblyPage->showBranches->isChecked());
         settings->setShowHexdump(disassemblyPage->showHexdump->isChecked());
         settings->setTabWidth(disassemblyPage->tabWidth->value());
+        settings->setPersistentDisassemblyCache(disassemblyPage->persistentCache->isChecked());
+        settings->setDisassemblyPrefetchDepth(disassemblyPage->prefetchDepth->value());
     });
 
     for (auto field : {disassemblyPage->lineEditObjdump}) {
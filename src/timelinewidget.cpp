@@ -15,6 +15,7 @@
 #include "data.h"
 #include "parsers/perf/perfparser.h"
 
+#include <QBitArray>
 #include <QLabel>
 #include <QPointer>
 #include <QProgressBar>
@@ -49,6 +50,23 @@ void scheduleJob(Context* context, std::atomic<uint>* currentJobId, Job&& job, S
             Qt::QueuedConnection);
     });
 }
+
+struct SelectedStacks
+{
+    QBitArray stacks;
+    std::shared_ptr<const Data::SymbolStackIndex> index;
+};
+
+std::shared_ptr<const Data::SymbolStackIndex> ensureIndex(std::shared_ptr<const Data::SymbolStackIndex> index,
+                                                          const QVector<QVector<qint32>>& stacks,
+                                                          const Data::BottomUpResults& bottomUpResults)
+{
+    if (!index) {
+        index = std::make_shared<const Data::SymbolStackIndex>(
+            Data::SymbolStackIndex::fromStacks(stacks, bottomUpResults));
+    }
+    return index;
+}
 }
 
 TimeLineWidget::TimeLineWidget(PerfParser* parser, QMenu* filterMenu, FilterAndZoomStack* filterAndZoomStack,
@@ -86,10 +104,12 @@ TimeLineWidget::TimeLineWidget(PerfParser* parser, QMenu* filterMenu, FilterAndZ
     connect(timeLineProxy, &QAbstractItemModel::modelReset, this, [this]() { ui->timeLineView->expandToDepth(1); });
 
     connect(m_parser, &PerfParser::bottomUpDataAvailable, this, [this](const Data::BottomUpResults& data) {
+        resetSymbolStackIndex();
         ResultsUtil::fillEventSourceComboBox(ui->timeLineEventSource, data.costs, tr("Show timeline for %1 events."));
     });
 
     connect(m_parser, &PerfParser::eventsAvailable, this, [this, eventModel](const Data::EventResults& data) {
+        resetSymbolStackIndex();
         eventModel->setData(data);
         ui->timeLineView->sortByColumn(EventModel::ThreadColumn, Qt::AscendingOrder);
         m_timeAxisHeaderView->setTimeRange(eventModel->timeRange());
@@ -152,6 +172,13 @@ TimeLineWidget::TimeLineWidget(PerfParser* parser, QMenu* filterMenu, FilterAndZ
 
 TimeLineWidget::~TimeLineWidget() = default;
 
+void TimeLineWidget::resetSymbolStackIndex()
+{
+    // the running selection jobs may still use the old index, don't let them store it
+    ++m_currentSelectStackJobId;
+    m_symbolStackIndex.reset();
+}
+
 void TimeLineWidget::selectSymbol(const Data::Symbol& symbol)
 {
     if (!symbol.isValid()) {
@@ -165,28 +192,18 @@ void TimeLineWidget::selectSymbol(const Data::Symbol& symbol)
 
     scheduleJob(
         m_timeLineDelegate, &m_currentSelectStackJobId,
-        [stacks, bottomUpResults, symbol](auto jobCancelled) -> QSet<qint32> {
-            const auto numStacks = stacks.size();
-            QSet<qint32> selectedStacks;
-            selectedStacks.reserve(numStacks);
-            for (int i = 0; i < numStacks; ++i) {
-                if (jobCancelled())
-                    return {};
-                bool symbolFound = false;
-                bottomUpResults.foreachFrame(stacks[i], [&](const Data::Symbol& frame, const Data::Location&) {
-                    if (jobCancelled())
-                        return false;
-                    symbolFound = (frame == symbol);
-                    // break once we find the symbol we are looking for
-                    return !symbolFound;
-                });
-                if (symbolFound)
-                    selectedStacks.insert(i);
-            }
-
-            return selectedStacks;
+        [stacks, bottomUpResults, symbol, index = m_symbolStackIndex](auto /*jobCancelled*/) -> SelectedStacks {
+            SelectedStacks selected;
+            selected.index = ensureIndex(index, stacks, bottomUpResults);
+            selected.stacks.resize(stacks.size());
+            for (auto stackId : selected.index->stacksForSymbol(symbol))
+                selected.stacks.setBit(stackId);
+            return selected;
         },
-        [this](const QSet<qint32>& selectedStacks) { m_timeLineDelegate->setSelectedStacks(selectedStacks); });
+        [this](const SelectedStacks& selected) {
+            m_symbolStackIndex = selected.index;
+            m_timeLineDelegate->setSelectedStacks(selected.stacks);
+        });
 }
 
 void TimeLineWidget::selectStack(const QVector<Data::Symbol>& stack, bool bottomUp)
@@ -202,26 +219,30 @@ void TimeLineWidget::selectStack(const QVector<Data::Symbol>& stack, bool bottom
 
     scheduleJob(
         m_timeLineDelegate, &m_currentSelectStackJobId,
-        [stacks, bottomUpResults, stack, bottomUp](auto jobCancelled) -> QSet<qint32> {
-            const auto numStacks = stacks.size();
-            QSet<qint32> selectedStacks;
-            selectedStacks.reserve(numStacks);
+        [stacks, bottomUpResults, stack, bottomUp, index = m_symbolStackIndex](auto jobCancelled) -> SelectedStacks {
+            SelectedStacks selected;
+            selected.index = ensureIndex(index, stacks, bottomUpResults);
+            selected.stacks.resize(stacks.size());
+
+            // only stacks that contain all of the symbols can match, so start from the rarest one
+            const QVector<qint32>* candidates = nullptr;
+            for (const auto& symbol : stack) {
+                const auto& symbolStacks = selected.index->stacksForSymbol(symbol);
+                if (!candidates || symbolStacks.size() < candidates->size())
+                    candidates = &symbolStacks;
+            }
+
             QVarLengthArray<Data::Symbol, 64> frames;
-            for (int i = 0; i < numStacks; ++i) {
+            for (auto stackId : *candidates) {
                 if (jobCancelled())
-                    return {};
+                    return selected;
 
                 frames.clear();
-                bottomUpResults.foreachFrame(stacks[i], [&](const Data::Symbol& frame, const Data::Location&) {
-                    if (jobCancelled())
-                        return false;
+                bottomUpResults.foreachFrame(stacks[stackId], [&](const Data::Symbol& frame, const Data::Location&) {
                     frames.append(frame);
                     return true;
                 });
 
-                if (jobCancelled())
-                    return {};
-
                 if (frames.size() < stack.size())
                     continue;
 
@@ -235,10 +256,14 @@ void TimeLineWidget::selectStack(const QVector<Data::Symbol>& stack, bool bottom
                     }
                 }();
                 if (matches)
-                    selectedStacks.insert(i);
+                    selected.stacks.setBit(stackId);
             }
 
-            return selectedStacks;
+            return selected;
         },
-        [this](const QSet<qint32>& selectedStacks) { m_timeLineDelegate->setSelectedStacks(selectedStacks); });
+        [this](const SelectedStacks& selected) {
+            m_symbolStackIndex = selected.index;
+            m_timeLineDelegate->setSelectedStacks(selected.stacks);
+        });
 }
+
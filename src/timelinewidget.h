@@ -18,6 +18,7 @@ class TimeLineWidget;
 
 namespace Data {
 struct Symbol;
+struct SymbolStackIndex;
 }
 
 class PerfParser;
@@ -42,6 +43,8 @@ signals:
     void stacksHovered(const QVector<QVector<Data::Symbol>>& stacks);
 
 private:
+    void resetSymbolStackIndex();
+
     std::unique_ptr<Ui::TimeLineWidget> ui;
 
     PerfParser* m_parser = nullptr;
@@ -50,4 +53,6 @@ private:
     TimeAxisHeaderView* m_timeAxisHeaderView = nullptr;
     std::atomic<uint> m_currentSelectStackJobId;
     std::atomic<uint> m_currentHoverStacksJobId;
+    // built lazily on the first selection, reset whenever new results arrive
+    std::shared_ptr<const Data::SymbolStackIndex> m_symbolStackIndex;
 };
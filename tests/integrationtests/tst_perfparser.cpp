@@ -671,6 +671,65 @@ private slots:
         QVERIFY(m_bottomUpData.costs.cost(2, topBottomUp.id) >= 1E9); // at least 1s sleep time
     }
 
+    void testOffCpuLocking()
+    {
+        if (!m_capabilities.canProfileOffCpu) {
+            QSKIP("cannot access sched_switch trace points. execute the following to run this test:\n"
+                  "    sudo mount -o remount,mode=755 /sys/kernel/debug{,/tracing} with mode=755");
+        }
+
+        QStringList perfOptions = {QStringLiteral("--call-graph"), QStringLiteral("dwarf"), QStringLiteral("-e"),
+                                   QStringLiteral("cycles")};
+        perfOptions += PerfRecord::offCpuProfilingOptions();
+
+        const QString exePath = findExe(QStringLiteral("cpp-locking"));
+
+        QTemporaryFile tempFile;
+        QVERIFY(tempFile.open());
+
+        try {
+            // more workers than by default, to get plenty of lock contention
+            perfRecord(perfOptions, exePath, {QStringLiteral("20000")}, tempFile.fileName());
+            testPerfData({}, {}, tempFile.fileName(), false);
+        } catch (...) {
+        }
+
+        QCOMPARE(m_bottomUpData.costs.numTypes(), 3);
+        QCOMPARE(m_bottomUpData.costs.typeName(2), QStringLiteral("off-CPU Time"));
+        QVERIFY(m_bottomUpData.costs.totalCost(1) > 0);
+        QVERIFY(m_bottomUpData.costs.totalCost(2) > 0);
+        QVERIFY(m_summaryData.offCpuTime > 0);
+
+        // the off-CPU time is attributed to the stack of the sched switch, i.e. the workers waiting for the lock
+        const int bottomUpTopIndex = maxElementTopIndex(m_bottomUpData, 2);
+        QVERIFY(bottomUpTopIndex != -1);
+        const auto& topBottomUp = m_bottomUpData.root.children[bottomUpTopIndex];
+        QCOMPARE(ComparableSymbol(topBottomUp.symbol),
+                 ComparableSymbol({{QStringLiteral("schedule"), QStringLiteral("kernel")},
+                                   {QStringLiteral("__schedule"), QString()}}));
+        auto findWorker = [](const Data::BottomUp& node, const auto& findWorker) -> const Data::BottomUp* {
+            for (const auto& child : node.children) {
+                if (child.symbol.symbol.contains(QLatin1String("worker"))) {
+                    return &child;
+                }
+                if (const auto* worker = findWorker(child, findWorker)) {
+                    return worker;
+                }
+            }
+            return nullptr;
+        };
+        const auto* worker = findWorker(topBottomUp, findWorker);
+        QVERIFY(worker);
+        QVERIFY(m_bottomUpData.costs.cost(1, worker->id) > 0);
+        QVERIFY(m_bottomUpData.costs.cost(2, worker->id) > 0);
+
+        for (const auto& thread : std::as_const(m_eventData.threads)) {
+            // the off-CPU events are added when we get switched in again, ensure we still get sorted events
+            QVERIFY(std::is_sorted(thread.events.cbegin(), thread.events.cend(),
+                                   [](const Data::Event& lhs, const Data::Event& rhs) { return lhs.time < rhs.time; }));
+        }
+    }
+
     void testOffCpuSleep()
     {
         const auto sleep = QStandardPaths::findExecutable(QStringLiteral("sleep"));
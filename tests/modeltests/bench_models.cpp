@@ -0,0 +1,60 @@
+/*
+    SPDX-FileCopyrightText: Milian Wolff <milian.wolff@kdab.com>
+    SPDX-FileCopyrightText: 2016 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include <QObject>
+#include <QTest>
+
+#include <models/data.h>
+
+// benchmarks for the models, these are built but not run as part of the unit tests
+class BenchModels : public QObject
+{
+    Q_OBJECT
+private slots:
+    void benchmarkClipToTimeRange_data()
+    {
+        QTest::addColumn<int>("numEvents");
+        QTest::addColumn<int>("selectedPercent");
+
+        for (int numEvents : {100000, 1000000}) {
+            for (int selectedPercent : {1, 10, 100}) {
+                QTest::addRow("%d events, %d%% selected", numEvents, selectedPercent) << numEvents << selectedPercent;
+            }
+        }
+    }
+
+    void benchmarkClipToTimeRange()
+    {
+        QFETCH(int, numEvents);
+        QFETCH(int, selectedPercent);
+
+        Data::Events events;
+        events.reserve(numEvents);
+        for (int i = 0; i < numEvents; ++i) {
+            Data::Event event;
+            event.time = 1000 + i * 10;
+            event.cost = i;
+            events.append(event);
+        }
+
+        const auto start = events.first().time;
+        const auto delta = (events.last().time - start) * selectedPercent / 100;
+        // use a range in the middle of the data, but not one that spans all events
+        const auto range = Data::TimeRange(start + 1, start + 1 + delta);
+
+        int selected = 0;
+        QBENCHMARK {
+            selected = Data::clipToTimeRange(events, range).size();
+        }
+        QVERIFY(selected > 0);
+        QVERIFY(selected <= numEvents);
+    }
+};
+
+QTEST_GUILESS_MAIN(BenchModels)
+
+#include "bench_models.moc"
@@ -13,12 +13,15 @@
 #include <QStandardPaths>
 #include <QString>
 #include <QStringList>
+#include <QTemporaryDir>
 #include <QTemporaryFile>
 #include <QTest>
 #include <QVector>
 
 #include <data.h>
+#include <models/disassemblycache.h>
 #include <models/disassemblyoutput.h>
+#include <models/sourcefilecache.h>
 
 #include "../testutils.h"
 
@@ -198,6 +201,65 @@ private slots:
                  tempDir.path() + QDir::separator() + QStringLiteral("liba/lib.c"));
     }
 
+    void testSourceFileCache()
+    {
+        QTemporaryDir tempDir;
+        QVERIFY(tempDir.isValid());
+
+        const auto path = tempDir.path() + QDir::separator() + QStringLiteral("lib.c");
+        SourceFileCache cache;
+
+        // misses are cached too, until the cache gets cleared
+        QCOMPARE(cache.resolve(QStringLiteral("/home/test/lib.c"), {tempDir.path()}, QString()),
+                 QStringLiteral("/home/test/lib.c"));
+        QVERIFY(!cache.file(path));
+
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write("int main()\r\n{\n    return 0;\n}\n");
+        file.close();
+
+        QCOMPARE(cache.resolve(QStringLiteral("/home/test/lib.c"), {tempDir.path()}, QString()),
+                 QStringLiteral("/home/test/lib.c"));
+        cache.clear();
+        QCOMPARE(cache.resolve(QStringLiteral("/home/test/lib.c"), {tempDir.path()}, QString()),
+                 QFileInfo(path).canonicalFilePath());
+
+        const auto sourceFile = cache.file(path);
+        QVERIFY(sourceFile);
+        QCOMPARE(sourceFile->lineCount(), 5);
+        QCOMPARE(sourceFile->line(0), QStringLiteral("int main()"));
+        QCOMPARE(sourceFile->line(4), QString());
+        QCOMPARE(sourceFile->lines(1, 2), QStringList({QStringLiteral("{"), QStringLiteral("    return 0;")}));
+        QCOMPARE(sourceFile->lines(3), QStringList({QStringLiteral("}"), QString()}));
+        QCOMPARE(sourceFile->lines(),
+                 QString::fromUtf8("int main()\n{\n    return 0;\n}\n").split(QLatin1Char('\n')));
+
+        // the same file is shared
+        QVERIFY(cache.file(path) == sourceFile);
+
+        // large files keep their contents when they get truncated, the cache then loads them again
+        const auto largePath = tempDir.path() + QDir::separator() + QStringLiteral("large.c");
+        QFile largeFile(largePath);
+        QVERIFY(largeFile.open(QIODevice::WriteOnly));
+        for (int i = 0; i < 100000; ++i) {
+            largeFile.write("int variable = 0; // some padding\n");
+        }
+        largeFile.close();
+
+        const auto largeSourceFile = cache.file(largePath);
+        QVERIFY(largeSourceFile);
+        QCOMPARE(largeSourceFile->line(0), QStringLiteral("int variable = 0; // some padding"));
+
+        QVERIFY(largeFile.open(QIODevice::WriteOnly | QIODevice::Truncate));
+        largeFile.close();
+        QCOMPARE(largeSourceFile->line(99999), QStringLiteral("int variable = 0; // some padding"));
+        QCOMPARE(largeSourceFile->lines().size(), 100001);
+        const auto truncatedFile = cache.file(largePath);
+        QVERIFY(truncatedFile != largeSourceFile);
+        QCOMPARE(truncatedFile->lineCount(), 1);
+    }
+
     /* tests for check results via error messages,
        note: as they are formatted and may be changed later, we check for the components separately */
     void testDisassembleChecks()
@@ -387,6 +449,112 @@ private slots:
         QCOMPARE(symbol.canDisassemble(), canDisassemble);
     }
 
+    void testCache()
+    {
+        const auto lib = findLib(QStringLiteral("libfib.so"));
+        QVERIFY(QFile::exists(lib));
+
+        const auto flags = QStringList {mObjdumpBinary, QStringLiteral("-d")};
+        const auto key = DisassemblyCache::key(lib, 4361, 4361 + 67, flags);
+        QVERIFY(key.isValid());
+        QVERIFY(!DisassemblyCache::key(QStringLiteral("/does/not/exist"), 0, 1, flags).isValid());
+
+        DisassemblyOutput::ObjectdumpOutput output;
+        output.mainSourceFileName = QStringLiteral("fib.cpp");
+        output.disassemblyLines.push_back({0x1109,
+                                           QStringLiteral("push   %rbp"),
+                                           {},
+                                           QStringLiteral("55"),
+                                           {QStringLiteral("fib"), 4},
+                                           {QStringLiteral("fib.cpp"), 3}});
+
+        QTemporaryDir cacheDir;
+        QVERIFY(cacheDir.isValid());
+
+        {
+            DisassemblyCache cache(2);
+            cache.setDiskCacheDirectory(cacheDir.path());
+            QVERIFY(!cache.find(key));
+            cache.insert(key, output);
+
+            const auto cached = cache.find(key);
+            QVERIFY(cached);
+            QCOMPARE(cached->mainSourceFileName, output.mainSourceFileName);
+            QCOMPARE(cached->disassemblyLines.size(), 1);
+
+            // a different address range or different flags must not reuse the entry
+            QVERIFY(!cache.find(DisassemblyCache::key(lib, 4361, 4361 + 68, flags)));
+            QVERIFY(!cache.find(DisassemblyCache::key(lib, 4361, 4361 + 67, {mObjdumpBinary})));
+        }
+
+        // a new cache picks up the entries stored on disk
+        {
+            DisassemblyCache cache;
+            QVERIFY(!cache.find(key));
+            cache.setDiskCacheDirectory(cacheDir.path());
+            const auto cached = cache.find(key);
+            QVERIFY(cached);
+            QCOMPARE(cached->mainSourceFileName, output.mainSourceFileName);
+            QCOMPARE(cached->disassemblyLines.size(), 1);
+            const auto& line = cached->disassemblyLines.first();
+            QCOMPARE(line.addr, quint64(0x1109));
+            QCOMPARE(line.disassembly, output.disassemblyLines.first().disassembly);
+            QCOMPARE(line.hexdump, output.disassemblyLines.first().hexdump);
+            QCOMPARE(line.linkedFunction.name, QStringLiteral("fib"));
+            QCOMPARE(line.linkedFunction.offset, 4);
+            QCOMPARE(line.fileLine, output.disassemblyLines.first().fileLine);
+        }
+
+        // disassembling the same symbol twice yields the same result
+        const Data::Symbol symbol = {QStringLiteral("fib(int)"), 4361, 67, QStringLiteral("libfib.so"), {}, lib};
+        const auto first = DisassemblyOutput::disassemble(mObjdumpBinary, {}, {}, {}, {}, {}, symbol);
+        QVERIFY(first.errorMessage.isEmpty());
+        const auto second = DisassemblyOutput::disassemble(mObjdumpBinary, {}, {}, {}, {}, {}, symbol);
+        QVERIFY(second.errorMessage.isEmpty());
+        QCOMPARE(second.disassemblyLines.size(), first.disassemblyLines.size());
+        QCOMPARE(second.mainSourceFileName, first.mainSourceFileName);
+    }
+
+    void testPrefetch()
+    {
+        const auto binary = QFINDTESTDATA("vector_static_gcc/vector_static_gcc_v9.1.0");
+        QVERIFY(!binary.isEmpty());
+
+        auto symbol = [&binary](const QString& name, quint64 relAddr, quint64 size) {
+            return Data::Symbol {name, relAddr, size, QStringLiteral("vector_static_gcc_v9.1.0"), binary, binary};
+        };
+        const auto sinFma4 = symbol(QStringLiteral("__sin_fma4"), 0x418fc0, 0x860);
+        const auto cosFma4 = symbol(QStringLiteral("__cos_fma4"), 0x419820, 0x863);
+
+        DisassemblyCache::instance()->clear();
+        QVector<DisassemblyOutput> expected;
+        for (const auto& symbol : {sinFma4, cosFma4}) {
+            expected.append(DisassemblyOutput::disassemble(mObjdumpBinary, {}, {}, {}, {}, {}, symbol));
+            QVERIFY(expected.last().errorMessage.isEmpty());
+        }
+
+        // both symbols get disassembled by one objdump run and then split up again
+        DisassemblyCache::instance()->clear();
+        QCOMPARE(DisassemblyOutput::prefetch(mObjdumpBinary, {}, {}, {sinFma4, cosFma4}), 2);
+        QCOMPARE(DisassemblyOutput::prefetch(mObjdumpBinary, {}, {}, {sinFma4, cosFma4}), 0);
+
+        for (const auto& expectedOutput : expected) {
+            const auto cached =
+                DisassemblyOutput::disassemble(mObjdumpBinary, {}, {}, {}, {}, {}, expectedOutput.symbol);
+            QVERIFY(cached.errorMessage.isEmpty());
+            QCOMPARE(cached.mainSourceFileName, expectedOutput.mainSourceFileName);
+            QCOMPARE(cached.disassemblyLines.size(), expectedOutput.disassemblyLines.size());
+            for (int i = 0; i < cached.disassemblyLines.size(); ++i) {
+                const auto& line = cached.disassemblyLines[i];
+                const auto& expectedLine = expectedOutput.disassemblyLines[i];
+                QCOMPARE(line.addr, expectedLine.addr);
+                QCOMPARE(line.disassembly, expectedLine.disassembly);
+                QCOMPARE(line.branchVisualisation, expectedLine.branchVisualisation);
+                QCOMPARE(line.hexdump, expectedLine.hexdump);
+            }
+        }
+    }
+
 private:
     struct FunctionData
     {
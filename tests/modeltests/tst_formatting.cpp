@@ -38,6 +38,7 @@ private slots:
         QTest::addRow("complex ansi codes")
             << QStringLiteral("\033[40;1m A \033[41;1m B \033[42;1m C \033[43;1m D \033[0m")
             << QStringLiteral(" A  B  C  D ");
+        QTest::addRow("unterminated ansi code") << QStringLiteral("A \033[40;1m B \033[41") << QStringLiteral("A  B ");
     }
 
     void testRemoveAnsi()
@@ -181,6 +182,48 @@ private slots:
         }
 #else
         QSKIP("Test requires KSyntaxHighlighting");
+#endif // KFSyntaxHighlighting_FOUND
+    }
+
+    void testLazyHighlighting()
+    {
+#if KFSyntaxHighlighting_FOUND
+        // a comment that spans far more lines than get highlighted at once
+        QStringList lines = {QStringLiteral("int test() {"), QStringLiteral("/* start")};
+        for (int i = 0; i < 1000; ++i) {
+            lines.append(QStringLiteral(" * comment line %1").arg(i));
+        }
+        lines.append({QStringLiteral(" */"), QStringLiteral("return 0;"), QStringLiteral("}")});
+
+        auto repository = std::make_unique<KSyntaxHighlighting::Repository>();
+
+        HighlightedText text(repository.get());
+        text.setText(lines);
+        text.setDefinition(repository->definitionForFileName(QStringLiteral("test.cpp")));
+
+        // jump to the end first, the state has to be carried over from the start of the comment
+        const int returnLine = lines.size() - 2;
+        const auto returnFormats = text.layoutForLine(returnLine)->formats();
+        const auto lastCommentFormats = text.layoutForLine(returnLine - 2)->formats();
+        QVERIFY(!lastCommentFormats.isEmpty());
+        const auto commentFormat = lastCommentFormats[0].format;
+        for (const auto& format : returnFormats) {
+            QVERIFY(format.format != commentFormat);
+        }
+
+        const auto firstCommentFormats = text.layoutForLine(2)->formats();
+        QVERIFY(!firstCommentFormats.isEmpty());
+        QCOMPARE(firstCommentFormats[0].format, commentFormat);
+
+        // the result must not depend on the order in which the lines got requested
+        HighlightedText sequential(repository.get());
+        sequential.setText(lines);
+        sequential.setDefinition(repository->definitionForFileName(QStringLiteral("test.cpp")));
+        for (int line = 0; line < lines.size(); ++line) {
+            QVERIFY(sequential.layoutForLine(line)->formats() == text.layoutForLine(line)->formats());
+        }
+#else
+        QSKIP("Test requires KSyntaxHighlighting");
 #endif // KFSyntaxHighlighting_FOUND
     }
 };
@@ -15,12 +15,17 @@
 #include <QTemporaryFile>
 #include <QTest>
 #include <QTextStream>
+#include <QThread>
 
 #include "../testutils.h"
 #include "search.h"
 
+#include <models/callercalleeproxy.h>
+#include <models/costproxy.h>
 #include <models/disassemblymodel.h>
 #include <models/eventmodel.h>
+#include <models/frequencypyramid.h>
+#include <models/processmodel.h>
 #include <models/sourcecodemodel.h>
 
 namespace {
@@ -69,6 +74,46 @@ Data::BottomUpResults generateTree1()
     )");
 }
 
+// @p numSymbols symbols that are sampled between one and seven times, all called by A when @p nested
+// the costs of the second type are unique, such that sorting by them has exactly one result
+Data::BottomUpResults generateHugeTree(int numSymbols, bool nested)
+{
+    QByteArray stacks;
+    for (int i = 1; i <= numSymbols; ++i) {
+        for (int j = 0; j < i % 7 + 1; ++j) {
+            stacks += QByteArray::number(i) + (nested ? ";A\n" : "\n");
+        }
+    }
+    auto tree = buildBottomUpTree(stacks);
+    tree.costs.addType(1, QStringLiteral("unique"), Data::Costs::Unit::Unknown);
+    for (quint32 id = 0, c = numSymbols + (nested ? 1 : 0); id < c; ++id) {
+        tree.costs.add(1, id, (id * 7919) % 10007 + 1);
+    }
+    return tree;
+}
+
+// the costs in @p column of all rows below @p parent
+QVector<qint64> columnCosts(const QAbstractItemModel& model, int column, const QModelIndex& parent = {})
+{
+    QVector<qint64> costs;
+    for (int row = 0, c = model.rowCount(parent); row < c; ++row) {
+        costs.append(model.index(row, column, parent).data(AbstractTreeModel::SortRole).toLongLong());
+    }
+    return costs;
+}
+
+// the costs in @p column of the source model, sorted like a proxy should show them
+QVector<qint64> sortedColumnCosts(const QAbstractItemModel& model, int column, Qt::SortOrder order,
+                                  const QModelIndex& parent = {})
+{
+    auto costs = columnCosts(model, column, parent);
+    std::sort(costs.begin(), costs.end());
+    if (order == Qt::DescendingOrder) {
+        std::reverse(costs.begin(), costs.end());
+    }
+    return costs;
+}
+
 Data::BottomUpResults generateTreeByThread()
 {
     return buildBottomUpTree(R"(
@@ -258,6 +303,129 @@ private slots:
         model.setData(tree);
     }
 
+    void testTopDownParallel_data()
+    {
+        QTest::addColumn<bool>("skipFirstLevel");
+
+        QTest::addRow("normal") << false;
+        QTest::addRow("skipFirstLevel") << true;
+    }
+
+    void testTopDownParallel()
+    {
+        QFETCH(bool, skipFirstLevel);
+
+        // many more top-level bottom-up nodes than threads, such that the tree gets built in multiple chunks
+        QByteArray stacks;
+        QVector<QByteArrayList> topDownStacks;
+        for (int i = 0; i < 5000; ++i) {
+            QByteArrayList frames = {"main", "f" + QByteArray::number(i % 5)};
+            if (i % 2) {
+                frames.append("g" + QByteArray::number(i % 3));
+            }
+            if (i % 11) {
+                frames.append("leaf" + QByteArray::number(i % 257));
+            }
+            if (skipFirstLevel) {
+                frames.append("T" + QByteArray::number(i % 397));
+            }
+            stacks += frames.join(';') + '\n';
+
+            if (skipFirstLevel) {
+                frames.prepend(frames.takeLast());
+            }
+            topDownStacks.append(frames);
+        }
+        const auto bottomUpTree = buildBottomUpTree(stacks);
+        QVERIFY(bottomUpTree.root.children.size() > QThread::idealThreadCount());
+
+        // build the expected top-down tree directly from the stacks
+        Data::TopDownResults expected;
+        expected.inclusiveCosts.initializeCostsFrom(bottomUpTree.costs);
+        expected.selfCosts.initializeCostsFrom(bottomUpTree.costs);
+        quint32 maxId = 0;
+        for (const auto& frames : std::as_const(topDownStacks)) {
+            auto* node = &expected.root;
+            for (const auto& frame : frames) {
+                node = node->entryForSymbol({QString::fromUtf8(frame), {}}, &maxId);
+                expected.inclusiveCosts.increment(0, node->id);
+            }
+            expected.selfCosts.increment(0, node->id);
+        }
+
+        const auto tree = Data::TopDownResults::fromBottomUp(bottomUpTree, skipFirstLevel);
+        QCOMPARE(tree.inclusiveCosts.totalCost(0), qint64(5000));
+        QCOMPARE(printPaths(tree), printPaths(expected));
+    }
+
+    void testFetchMore()
+    {
+        // A gets called by many symbols, which are sampled between one and seven times
+        QByteArray stacks;
+        const int numSymbols = 2500;
+        for (int i = 1; i <= numSymbols; ++i) {
+            for (int j = 0; j < i % 7 + 1; ++j) {
+                stacks += QByteArray::number(i) + ";A\n";
+            }
+        }
+        const auto tree = buildBottomUpTree(stacks);
+
+        BottomUpModel model;
+        QAbstractItemModelTester tester(&model);
+        model.setData(tree);
+
+        // A and all the symbols calling it
+        QCOMPARE(model.rowCount(), 1);
+        const auto a = model.index(0, 0);
+        QCOMPARE(model.rowCount(a), 1000);
+        QVERIFY(model.canFetchMore(a));
+
+        // the most expensive children are fetched first
+        const auto costColumn = BottomUpModel::InitialSortColumn;
+        const auto cost = [&](int row) {
+            return model.index(row, costColumn, a).data(BottomUpModel::SortRole).toLongLong();
+        };
+        for (int row = 1; row < 1000; ++row) {
+            QVERIFY(cost(row - 1) >= cost(row));
+        }
+        QCOMPARE(cost(0), qint64(7));
+        QCOMPARE(cost(999), qint64(5));
+
+        model.fetchMore(a);
+        QCOMPARE(model.rowCount(a), 2000);
+        model.setFetchAll(true);
+        QCOMPARE(model.rowCount(a), numSymbols);
+        QVERIFY(!model.canFetchMore(a));
+
+        // the rows map back to the same nodes
+        for (int row = 0; row < numSymbols; ++row) {
+            const auto index = model.index(row, 0, a);
+            QCOMPARE(model.indexFromItem(model.itemFromIndex(index), 0), index);
+            QCOMPARE(model.parent(index), a);
+        }
+
+        // the top proxy only sees the few most expensive rows
+        const auto flatTree = buildBottomUpTree(stacks.replace(";A", ""));
+        model.setData(flatTree);
+        // fetching everything also applies to new data, until it gets unset again when the search is cleared
+        QCOMPARE(model.rowCount(), numSymbols);
+        model.setFetchAll(false);
+        model.setData(flatTree);
+        QCOMPARE(model.rowCount(), 1000);
+        const auto topRows = model.topRows(costColumn, 5);
+        QCOMPARE(topRows.size(), 5);
+        for (auto row : topRows) {
+            QCOMPARE(model.index(row, costColumn).data(BottomUpModel::SortRole).toLongLong(), qint64(7));
+        }
+
+        TopProxy proxy;
+        proxy.setSourceModel(&model);
+        QCOMPARE(proxy.rowCount(), 5);
+        for (int row = 0; row < 5; ++row) {
+            QCOMPARE(proxy.index(row, 2).data(BottomUpModel::SortRole).toLongLong(), qint64(7));
+        }
+    }
+
     void testTopProxy()
     {
         BottomUpModel model;
@@ -278,6 +446,89 @@ private slots:
         }
     }
 
+    void testCostProxySorting_data()
+    {
+        QTest::addColumn<bool>("nested");
+
+        QTest::addRow("root") << false;
+        QTest::addRow("nested") << true;
+    }
+
+    void testCostProxySorting()
+    {
+        QFETCH(bool, nested);
+
+        const auto tree = generateHugeTree(2500, nested);
+        BottomUpModel model;
+        model.setData(tree);
+
+        CostProxy<BottomUpModel> proxy;
+        proxy.setSourceModel(&model);
+
+        const auto sourceParent = nested ? model.index(0, 0) : QModelIndex();
+        // sorting by the ranks must give the same order as sorting by the costs, also for the rows fetched later
+        for (bool fetchAll : {false, true}) {
+            model.setFetchAll(fetchAll);
+            const auto parent = proxy.mapFromSource(sourceParent);
+            QCOMPARE(proxy.rowCount(parent), fetchAll ? 2500 : 1000);
+            for (int column = BottomUpModel::NUM_BASE_COLUMNS; column < model.columnCount(); ++column) {
+                for (auto order : {Qt::DescendingOrder, Qt::AscendingOrder}) {
+                    proxy.sort(column, order);
+                    QCOMPARE(columnCosts(proxy, column, parent),
+                             sortedColumnCosts(model, column, order, sourceParent));
+                }
+            }
+        }
+    }
+
+    void testCallerCalleeProxySorting()
+    {
+        const auto tree = generateHugeTree(2500, true);
+        Data::CallerCalleeResults results;
+        Data::callerCalleesFromBottomUpData(tree, &results);
+
+        CallerCalleeModel model;
+        model.setResults(results);
+        QCOMPARE(model.rowCount(), 2501);
+
+        CallerCalleeProxy<CallerCalleeModel> proxy;
+        QAbstractItemModelTester tester(&proxy);
+        proxy.setSourceModel(&model);
+
+        for (int column = CallerCalleeModel::NUM_BASE_COLUMNS; column < model.columnCount(); ++column) {
+            for (auto order : {Qt::DescendingOrder, Qt::AscendingOrder}) {
+                proxy.sort(column, order);
+                QCOMPARE(columnCosts(proxy, column), sortedColumnCosts(model, column, order));
+            }
+        }
+    }
+
+    void testTopProxyHugeRoot()
+    {
+        // more top level rows than get fetched at once
+        const auto tree = generateHugeTree(2500, false);
+        BottomUpModel model;
+        model.setData(tree);
+        QVERIFY(model.canFetchMore({}));
+
+        TopProxy proxy;
+        proxy.setSourceModel(&model);
+
+        // compare with a full sort of all top level nodes, the unique costs ensure these are the very same rows
+        for (int type = 0; type < tree.costs.numTypes(); ++type) {
+            proxy.setCostColumn(BottomUpModel::NUM_BASE_COLUMNS + type);
+            QVector<qint64> expected;
+            for (const auto& child : tree.root.children) {
+                expected.append(tree.costs.cost(type, child.id));
+            }
+            std::sort(expected.begin(), expected.end(), std::greater<>());
+            expected.resize(5);
+
+            QCOMPARE(proxy.rowCount(), 5);
+            QCOMPARE(columnCosts(proxy, BottomUpModel::NUM_BASE_COLUMNS), expected);
+        }
+    }
+
     void testCallerCalleeModel()
     {
         const auto tree = generateTree1();
@@ -321,6 +572,46 @@ private slots:
         }
     }
 
+    void testBinaryOffsetCosts()
+    {
+        Data::BinaryOffsetCosts costs;
+        auto add = [&costs](quint64 addr, qint64 cost) {
+            auto& locationCost = costs.cost(addr, 1);
+            locationCost.selfCost[0] += cost;
+            locationCost.inclusiveCost[0] += cost;
+        };
+
+        add(0x30, 5);
+        add(0x10, 1);
+        add(0x20, 7);
+        add(0x10, 2);
+        QCOMPARE(costs.size(), 3);
+        QCOMPARE(costs.find(0x10)->selfCost[0], 3);
+        QVERIFY(!costs.find(0x15));
+
+        costs.finalize();
+        QCOMPARE(costs.size(), 3);
+        QCOMPARE(costs.find(0x10)->selfCost[0], 3);
+        QCOMPARE(costs.find(0x20)->selfCost[0], 7);
+        QCOMPARE(costs.find(0x30)->selfCost[0], 5);
+        QVERIFY(!costs.find(0x15));
+
+        // costs can still be added after finalizing, both to existing and new addresses
+        add(0x20, 1);
+        add(0x15, 4);
+        add(0x40, 5);
+        QCOMPARE(costs.find(0x20)->selfCost[0], 8);
+        QCOMPARE(costs.find(0x15)->selfCost[0], 4);
+        QCOMPARE(costs.hottestAddresses(0, 3), (QVector<quint64> {0x20, 0x30, 0x40}));
+
+        costs.finalize();
+        QCOMPARE(costs.size(), 5);
+        for (const auto addr : {0x10, 0x15, 0x20, 0x30, 0x40}) {
+            QVERIFY(costs.find(addr));
+        }
+        QCOMPARE(costs.hottestAddresses(0, 10), (QVector<quint64> {0x20, 0x30, 0x40, 0x15, 0x10}));
+    }
+
     void testDisassemblyModel_data()
     {
         QTest::addColumn<Data::Symbol>("symbol");
@@ -941,7 +1232,323 @@ private slots:
                  QStringLiteral("Foo<&bar::operator()>::asdf<XYZ>(blabla<&foo::opera…)"));
     }
 
+    void testSymbolStackIndex()
+    {
+        const auto mainSymbol = Data::Symbol(QStringLiteral("main"));
+        const auto fooSymbol = Data::Symbol(QStringLiteral("foo"));
+        const auto barSymbol = Data::Symbol(QStringLiteral("bar"));
+        const auto bazSymbol = Data::Symbol(QStringLiteral("baz"));
+
+        Data::BottomUpResults bottomUp;
+        // main <- foo <- bar, main <- baz <- invalid entry point which resolves to baz
+        bottomUp.symbols = {mainSymbol, fooSymbol, barSymbol, bazSymbol, {}};
+        bottomUp.locations = {Data::FrameLocation(-1), Data::FrameLocation(0), Data::FrameLocation(1),
+                              Data::FrameLocation(0), Data::FrameLocation(3)};
+        const QVector<QVector<qint32>> stacks = {{2}, {3}, {1}, {4}, {1, 2}};
+
+        const auto index = Data::SymbolStackIndex::fromStacks(stacks, bottomUp);
+        QCOMPARE(index.stacksForSymbol(mainSymbol), (QVector<qint32> {0, 1, 2, 3, 4}));
+        QCOMPARE(index.stacksForSymbol(fooSymbol), (QVector<qint32> {0, 2, 4}));
+        QCOMPARE(index.stacksForSymbol(barSymbol), (QVector<qint32> {0, 4}));
+        QCOMPARE(index.stacksForSymbol(bazSymbol), (QVector<qint32> {1, 3}));
+        QVERIFY(index.stacksForSymbol(Data::Symbol(QStringLiteral("unknown"))).isEmpty());
+
+        // the index must agree with walking the frames of every stack
+        for (const auto& symbol : {mainSymbol, fooSymbol, barSymbol, bazSymbol}) {
+            QVector<qint32> expected;
+            for (int i = 0; i < stacks.size(); ++i) {
+                bool found = false;
+                bottomUp.foreachFrame(stacks[i], [&](const Data::Symbol& frame, const Data::Location&) {
+                    found = frame == symbol;
+                    return !found;
+                });
+                if (found)
+                    expected.append(i);
+            }
+            QCOMPARE(index.stacksForSymbol(symbol), expected);
+        }
+    }
+
+    void testSymbolMatches()
+    {
+        const auto fooSymbol = Data::Symbol(QStringLiteral("foo"), 0, 0, QStringLiteral("libfoo.so"));
+        const auto barSymbol = Data::Symbol(QStringLiteral("bar"), 0, 0, QStringLiteral("libbar.so"));
+        const auto unknownSymbol = Data::Symbol({}, 0, 0, QStringLiteral("libbar.so"));
+
+        const auto table = Data::SymbolTable::fromSymbols({fooSymbol, barSymbol, fooSymbol, unknownSymbol, {}});
+        QCOMPARE(table.symbols.size(), 3);
+        QCOMPARE(table.id(fooSymbol), 0);
+        QCOMPARE(table.id(barSymbol), 1);
+        QCOMPARE(table.id(Data::Symbol(QStringLiteral("baz"))), -1);
+
+        QVERIFY(!Data::SymbolMatches().isActive());
+
+        const auto matches = Data::SymbolMatches(table, QRegularExpression(QStringLiteral("foo")));
+        QVERIFY(matches.isActive());
+        QVERIFY(matches.matches(table.id(fooSymbol)));
+        QVERIFY(!matches.matches(barSymbol));
+        QVERIFY(!matches.matches(unknownSymbol));
+        // symbols outside of the table get matched directly
+        QVERIFY(matches.matches(Data::Symbol(QStringLiteral("foobar"))));
+
+        const auto binaryMatches = Data::SymbolMatches(table, QRegularExpression(QStringLiteral("libbar")));
+        QVERIFY(!binaryMatches.matches(fooSymbol));
+        QVERIFY(binaryMatches.matches(barSymbol));
+        QVERIFY(binaryMatches.matches(unknownSymbol));
+
+        const auto unknownMatches = Data::SymbolMatches(table, QRegularExpression(QStringLiteral("\\?\\?")));
+        QCOMPARE(unknownMatches.bits().count(true), 1);
+        QVERIFY(unknownMatches.matches(unknownSymbol));
+    }
+
+    void testTrigramIndex()
+    {
+        const QVector<Data::Symbol> symbols = {
+            Data::Symbol(QStringLiteral("QString::append"), 0, 0, QStringLiteral("libQt6Core.so")),
+            Data::Symbol(QStringLiteral("QVector::append"), 0, 0, QStringLiteral("libQt6Core.so")),
+            Data::Symbol(QStringLiteral("main"), 0, 0, QStringLiteral("app")),
+        };
+        Data::TrigramIndex index;
+        index.build(symbols);
+
+        QCOMPARE(index.candidates(QStringLiteral("append")), (QVector<qint32> {0, 1}));
+        QCOMPARE(index.candidates(QStringLiteral("STRING")), (QVector<qint32> {0}));
+        QCOMPARE(index.candidates(QStringLiteral("qt6core")), (QVector<qint32> {0, 1}));
+        QCOMPARE(index.candidates(QStringLiteral("mainx")), QVector<qint32>());
+        QVERIFY(!index.candidates(QStringLiteral("ma")));
+
+        // literal searches use the index, but must find the same symbols as matching everything
+        const auto table = Data::SymbolTable::fromSymbols(symbols);
+        QVERIFY(!table.trigrams.isEmpty());
+        for (const auto& search : {QStringLiteral("append"), QStringLiteral("ring::app"), QStringLiteral("ma"),
+                                   QStringLiteral("a.p"), QStringLiteral("nomatch")}) {
+            const auto pattern =
+                QRegularExpression(QRegularExpression::escape(search), QRegularExpression::CaseInsensitiveOption);
+            const auto matches = Data::SymbolMatches(table, pattern);
+            for (int id = 0; id < symbols.size(); ++id)
+                QCOMPARE(matches.matches(id), Data::SymbolMatches::matches(symbols[id], pattern));
+        }
+    }
+
+    void testSelectItems()
+    {
+        Data::Events events;
+        for (quint64 time = 0; time < 10; ++time) {
+            Data::Event event;
+            event.time = time;
+            events.append(event);
+        }
+
+        // selecting everything must not copy the data
+        const auto all = Data::selectItems(events, [](const Data::Event&) { return true; });
+        QCOMPARE(all, events);
+        QVERIFY(all.isSharedWith(events));
+
+        const auto odd = Data::selectItems(events, [](const Data::Event& event) { return event.time % 2; });
+        QCOMPARE(odd.size(), 5);
+        QVERIFY(!odd.isSharedWith(events));
+        for (int i = 0; i < odd.size(); ++i) {
+            QCOMPARE(odd[i].time, static_cast<quint64>(i * 2 + 1));
+        }
+
+        const auto none = Data::selectItems(events, [](const Data::Event&) { return false; });
+        QVERIFY(none.isEmpty());
+    }
+
+    void testClipToTimeRange()
+    {
+        Data::Events events;
+        for (quint64 time : {10, 20, 20, 30, 40}) {
+            Data::Event event;
+            event.time = time;
+            events.append(event);
+        }
+
+        auto times = [](const Data::Events& events) {
+            QVector<quint64> times;
+            for (const auto& event : events)
+                times.append(event.time);
+            return times;
+        };
+
+        QCOMPARE(times(Data::clipToTimeRange(events, {20, 30})), (QVector<quint64> {20, 20, 30}));
+        QCOMPARE(times(Data::clipToTimeRange(events, {0, 15})), (QVector<quint64> {10}));
+        QCOMPARE(times(Data::clipToTimeRange(events, {41, 50})), (QVector<quint64> {}));
+        QCOMPARE(times(Data::clipToTimeRange(events, {21, 29})), (QVector<quint64> {}));
+        QVERIFY(Data::clipToTimeRange(events, Data::MAX_TIME_RANGE).isSharedWith(events));
+
+        std::swap(events[0], events[4]);
+        Data::sortByTime(&events);
+        QCOMPARE(times(events), (QVector<quint64> {10, 20, 20, 30, 40}));
+    }
+
+    void testMergeProcesses()
+    {
+        auto procs = [](const QVector<std::pair<const char*, const char*>>& pidsAndStates) {
+            ProcDataList processes;
+            for (const auto& [pid, state] : pidsAndStates) {
+                ProcData proc;
+                proc.ppid = QString::fromLatin1(pid);
+                proc.name = QStringLiteral("proc") + proc.ppid;
+                proc.state = QString::fromLatin1(state);
+                processes.append(proc);
+            }
+            return processes;
+        };
+
+        ProcessModel model;
+        QAbstractItemModelTester tester(&model);
+        model.setProcesses(procs({{"5", "S"}, {"1", "S"}, {"2", "S"}, {"3", "S"}}));
+
+        QSignalSpy removedSpy(&model, &ProcessModel::rowsRemoved);
+        QSignalSpy insertedSpy(&model, &ProcessModel::rowsInserted);
+        QSignalSpy changedSpy(&model, &ProcessModel::dataChanged);
+
+        const auto newProcesses = procs({{"2", "S"}, {"3", "R"}, {"4", "S"}, {"6", "S"}, {"7", "S"}});
+        model.mergeProcesses(newProcesses);
+        QCOMPARE(model.rowCount(), 5);
+        for (int i = 0; i < newProcesses.size(); ++i) {
+            QVERIFY(model.dataForRow(i).equals(newProcesses[i]));
+        }
+
+        // pid 1 and 5 get removed, 4 and the run of 6 and 7 get inserted, 3 changed its state
+        QCOMPARE(removedSpy.count(), 2);
+        QCOMPARE(insertedSpy.count(), 2);
+        QCOMPARE(insertedSpy.last().at(1).toInt(), 3);
+        QCOMPARE(insertedSpy.last().at(2).toInt(), 4);
+        QCOMPARE(changedSpy.count(), 1);
+
+        model.mergeProcesses(newProcesses);
+        QCOMPARE(removedSpy.count(), 2);
+        QCOMPARE(insertedSpy.count(), 2);
+        QCOMPARE(changedSpy.count(), 1);
+
+        // a reused pid must update the row, even when everything else looks the same
+        auto reusedPid = newProcesses;
+        reusedPid[0].startTime = 42;
+        model.mergeProcesses(reusedPid);
+        QCOMPARE(changedSpy.count(), 2);
+        QCOMPARE(model.dataForRow(0).startTime, 42ull);
+    }
+
+    void testProcessList()
+    {
+        if (!QFile::exists(QStringLiteral("/proc/self/stat"))) {
+            QSKIP("Test requires /proc");
+        }
+
+        const auto pid = QString::number(QCoreApplication::applicationPid());
+        auto findSelf = [&pid](const ProcDataList& processes) {
+            return std::find_if(processes.cbegin(), processes.cend(),
+                                [&pid](const ProcData& proc) { return proc.ppid == pid; });
+        };
+
+        auto processes = processList();
+        QVERIFY(std::is_sorted(processes.cbegin(), processes.cend()));
+        const auto self = findSelf(processes);
+        QVERIFY(self != processes.cend());
+        QVERIFY(self->startTime > 0);
+        QVERIFY(self->name.contains(QLatin1String("tst_models")));
+
+        // known processes reuse their command line
+        const auto selfData = *self;
+        const auto selfIndex = std::distance(processes.cbegin(), self);
+        auto previous = processes;
+        previous[selfIndex].name = QStringLiteral("known");
+        processes = processList(previous);
+        QVERIFY(findSelf(processes) != processes.cend());
+        QCOMPARE(findSelf(processes)->name, QStringLiteral("known"));
+        QCOMPARE(findSelf(processes)->user, selfData.user);
+
+        // but not when the process called exec in the meantime
+        previous[selfIndex].comm = QStringLiteral("launcher");
+        processes = processList(previous);
+        QVERIFY(findSelf(processes) != processes.cend());
+        QCOMPARE(findSelf(processes)->name, selfData.name);
+    }
+
+    void testWindowedFrequencies()
+    {
+        Data::Events events;
+        auto addEvent = [&events](quint64 time, quint64 cost, qint32 type) {
+            Data::Event event;
+            event.time = time;
+            event.cost = cost;
+            event.type = type;
+            events.append(event);
+        };
+        addEvent(1000, 2000, 0);
+        addEvent(1500, 4000, 0);
+        addEvent(1600, 100, 1);
+        addEvent(4200, 1000, 0);
+
+        const auto frequencies = Data::windowedFrequencies(events, 0, 1000);
+        QCOMPARE(frequencies.size(), 2);
+        QCOMPARE(frequencies[0].time, 1500ull);
+        QCOMPARE(frequencies[0].cost, 6.);
+        QCOMPARE(frequencies[1].time, 4500ull);
+        QCOMPARE(frequencies[1].cost, 1.);
+
+        QCOMPARE(Data::windowedFrequencies(events, 1, 10000).size(), 1);
+        QCOMPARE(Data::windowedFrequencies(events, 1, 10000)[0].cost, 0.01);
+        QVERIFY(Data::windowedFrequencies(events, 2, 1000).isEmpty());
+        QVERIFY(Data::windowedFrequencies(events, 0, 0).isEmpty());
+    }
+
+    void testFrequencyPyramid()
+    {
+        // every tenth value is an outlier
+        QVector<Data::FrequencyData> values;
+        for (int i = 0; i < 1000; ++i) {
+            values.append({static_cast<quint64>(i) * 10, i % 10 ? 1. : 100.});
+        }
+
+        const FrequencyPyramid pyramid(values);
+        QCOMPARE(pyramid.numLevels(), 5);
+        QCOMPARE(pyramid.bins(1).size(), 250);
+        QCOMPARE(pyramid.bins(1).first().time, 0ull);
+        QCOMPARE(pyramid.bins(1).first().endTime, 30ull);
+        QCOMPARE(pyramid.bins(1).first().maxValue, 100.);
+        QCOMPARE(pyramid.bins(1).first().meanValue(), 103. / 4);
+
+        auto minMax = [](const QVector<Data::FrequencyData>& points) {
+            auto [min, max] = std::minmax_element(points.begin(), points.end(),
+                                                  [](const auto& lhs, const auto& rhs) { return lhs.cost < rhs.cost; });
+            return std::make_pair(min->cost, max->cost);
+        };
+
+        // zoomed out, the outliers must not get lost
+        const auto overview = pyramid.decimate(0, 10000, 100);
+        QVERIFY(overview.size() <= 300);
+        QCOMPARE(minMax(overview), std::make_pair(1., 100.));
+
+        // zoomed in, the values are used as they are
+        const auto details = pyramid.decimate(95, 150, 100);
+        QCOMPARE(details.size(), 6);
+        QCOMPARE(details.first().time, 100ull);
+        QCOMPARE(details.first().cost, 100.);
+        QCOMPARE(details.last().time, 150ull);
+
+        QVERIFY(pyramid.decimate(20000, 30000, 100).isEmpty());
+    }
+
 private:
+    // returns the full path and costs of every node, sorted to not depend on the order of the children
+    static QStringList printPaths(const Data::TopDownResults& results)
+    {
+        QStringList paths;
+        auto print = [&](const auto& print, const Data::TopDown& node, const QString& prefix) -> void {
+            for (const auto& child : node.children) {
+                const auto path = prefix + QLatin1Char('/') + child.symbol.symbol;
+                paths.append(path + QLatin1Char('=') + printCost(child, results));
+                print(print, child, path);
+            }
+        };
+        print(print, results.root, {});
+        paths.sort();
+        return paths;
+    }
+
     static QFontMetrics monospaceMetrics()
     {
         auto font = QFontDatabase::systemFont(QFontDatabase::FixedFont);
@@ -10,6 +10,7 @@
 #include <QTest>
 #include <QTextStream>
 
+#include <models/eventpyramid.h>
 #include <models/timelinedelegate.h>
 
 #include <cmath>
@@ -87,6 +88,70 @@ private slots:
             << data << (rect.width() / 2) << (time.start + time.delta() / 2) << time;
         QTest::newRow("maxTime_zoom_4th_quadrant") << data << rect.width() << time.end << time;
     }
+
+    void testEventPyramid()
+    {
+        Data::Events events;
+        quint64 totalCost = 0;
+        int numEvents = 0;
+        for (int i = 0; i < 10000; ++i) {
+            // interleave some events of another type which must be ignored
+            if (i % 7 == 0) {
+                events.append({1000 + static_cast<quint64>(i) * 10, 1000, 1, 2});
+            }
+            const auto cost = static_cast<quint64>(i % 100);
+            events.append({1000 + static_cast<quint64>(i) * 10 + 5, cost, 0, i == 4242 ? 42 : 1});
+            totalCost += cost;
+            ++numEvents;
+        }
+
+        const EventPyramid pyramid(events, 0);
+        QVERIFY(pyramid.numLevels() > 1);
+        QCOMPARE(pyramid.bins(pyramid.numLevels() - 1).size(), 1);
+
+        qsizetype lastSize = numEvents;
+        for (int level = 0; level < pyramid.numLevels(); ++level) {
+            const auto& bins = pyramid.bins(level);
+            const auto width = pyramid.binWidth(level);
+            QVERIFY(bins.size() * 2 <= lastSize);
+            lastSize = bins.size();
+            if (level) {
+                QVERIFY(width > pyramid.binWidth(level - 1));
+            }
+
+            quint64 levelCost = 0;
+            quint32 levelEvents = 0;
+            for (int i = 0; i < bins.size(); ++i) {
+                const auto& bin = bins[i];
+                QVERIFY(bin.maxCost <= 99);
+                QVERIFY(bin.endTime >= bin.time);
+                if (i) {
+                    QVERIFY(bins[i - 1].time / width < bin.time / width);
+                }
+                levelCost += bin.totalCost;
+                levelEvents += bin.numEvents;
+            }
+            QCOMPARE(levelCost, totalCost);
+            QCOMPARE(levelEvents, static_cast<quint32>(numEvents));
+        }
+
+        QCOMPARE(pyramid.levelForResolution(1), -1);
+        QCOMPARE(pyramid.levelForResolution(1e12), pyramid.numLevels() - 1);
+        QCOMPARE(pyramid.levelForResolution(pyramid.binWidth(0)), 0);
+
+        const auto mask = pyramid.highlightMask(events, [](qint32 stackId) { return stackId == 42; });
+        QCOMPARE(mask.size(), pyramid.numLevels());
+        const quint64 highlightedTime = 1000 + 4242 * 10 + 5;
+        for (int level = 0; level < pyramid.numLevels(); ++level) {
+            QCOMPARE(mask[level].count(true), 1);
+            const auto& bins = pyramid.bins(level);
+            for (int i = 0; i < bins.size(); ++i) {
+                if (mask[level].testBit(i)) {
+                    QCOMPARE(bins[i].time / pyramid.binWidth(level), highlightedTime / pyramid.binWidth(level));
+                }
+            }
+        }
+    }
 };
 
 QTEST_GUILESS_MAIN(TestTimeLineDelegate)
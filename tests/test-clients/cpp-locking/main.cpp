@@ -11,6 +11,7 @@
 #include <iostream>
 #include <mutex>
 #include <random>
+#include <string>
 #include <thread>
 #include <vector>
 
@@ -31,10 +32,13 @@ double worker()
     return s;
 }
 
-int main()
+int main(int argc, char** argv)
 {
+    // allow scaling the amount of lock contention, e.g. for off-CPU profiling tests
+    const int numWorkers = argc > 1 ? stoi(argv[1]) : 10000;
+
     vector<std::future<double>> results;
-    for (int i = 0; i < 10000; ++i) {
+    for (int i = 0; i < numWorkers; ++i) {
         results.push_back(async(launch::async, worker));
     }
     return 0;